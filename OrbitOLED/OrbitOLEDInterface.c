@@ -69,7 +69,7 @@ OLEDStringDraw(char *pcStr, uint32_t ulColumn, uint32_t ulRow)
     OrbitOledSetCursor(charX, charY);
 
     //Print the string:
-    OrbitOledPutString(pcStr);
+    OrbitOledPutStringFast(pcStr);
 }
 
 
@@ -35,6 +35,9 @@
 /*				Global Variables								*/
 /* ------------------------------------------------------------ */
 
+/* Word aligned so that each 8 byte glyph is two aligned words.
+*/
+#pragma DATA_ALIGN(rgbOledFont0, 4)
 const char rgbOledFont0[] = {
 #if defined(DEAD)
 	/* Remove definitions for character codes 0x00-0x1F as
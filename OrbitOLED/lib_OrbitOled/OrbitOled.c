@@ -25,6 +25,10 @@
 
 #include "delay.h"
 #include "LaunchPad.h"
+#include "inc/hw_ssi.h"
+#include "inc/hw_ints.h"
+#include "driverlib/udma.h"
+#include "driverlib/interrupt.h"
 #include "OrbitBoosterPackDefs.h"
 #include "OrbitOled.h"
 #include "OrbitOledChar.h"
@@ -39,7 +43,7 @@
 /*				Global Variables								*/
 /* ------------------------------------------------------------ */
 
-extern char		rgbOledFont0[];
+extern const char	rgbOledFont0[];
 extern char		rgbOledFontUser[];
 extern char		rgbFillPat[];
 
@@ -62,7 +66,7 @@ int		fOledCharUpdate;
 int		dxcoOledFontCur;
 int		dycoOledFontCur;
 
-char *	pbOledFontCur;
+const char *	pbOledFontCur;
 char *	pbOledFontUser;
 
 /* ------------------------------------------------------------ */
@@ -74,8 +78,38 @@ char *	pbOledFontUser;
 ** so display data is rendered into this offscreen buffer and then
 ** copied to the display.
 */
+/* Word aligned so that OrbitOledDrawGlyph can copy whole words.
+*/
+#pragma DATA_ALIGN(rgbOledBmp, 4)
 char	rgbOledBmp[cbOledDispMax];
 
+/* Span of columns in each page changed since the last update. A page
+** is clean when its left edge is past its right edge.
+*/
+int		rgcolOledDirtyLeft[cpagOledMax];
+int		rgcolOledDirtyRight[cpagOledMax];
+
+/* Number of bytes sent to the display by the last update, command
+** bytes included.
+*/
+int		cbOledUpdateLast;
+
+/* Asynchronous update. The changed spans are copied into rgbOledTx
+** when the update starts, so drawing into rgbOledBmp while it runs
+** is safe; anything drawn then goes out with the next update.
+*/
+#define	stOledAsyncIdle		0		//no update running
+#define	stOledAsyncCmd		1		//page/column commands shifting out
+#define	stOledAsyncData		2		//uDMA feeding page data
+#define	stOledAsyncDrain	3		//last page data shifting out
+
+char			rgbOledTx[cbOledDispMax];
+int				rgcolOledTxLeft[cpagOledMax];
+int				rgcolOledTxRight[cpagOledMax];
+volatile int	stOledAsync;
+int				ipagOledAsync;
+void			(*pfnOledAsyncDone)();
+
 /* ------------------------------------------------------------ */
 /*				Forward Declarations							*/
 /* ------------------------------------------------------------ */
@@ -85,6 +119,8 @@ void	OrbitOledDevInit();
 void	OrbitOledDvrInit();
 char	Ssi3PutByte(char bVal);
 void	OrbitOledPutBuffer(int cb, char * rgbTx);
+void	OrbitOledAsyncStartPage();
+void	OrbitOledSsi3IntHandler();
 
 /* ------------------------------------------------------------ */
 /*				Procedure Definitions							*/
@@ -238,6 +274,13 @@ OrbitOledDvrInit()
 	*/
 	fOledCharUpdate = 1;
 
+	/* Nothing to send until something is drawn.
+	*/
+	for (ib = 0; ib < cpagOledMax; ib++) {
+		rgcolOledDirtyLeft[ib] = ccolOledMax;
+		rgcolOledDirtyRight[ib] = -1;
+	}
+
 }
 
 /* ------------------------------------------------------------ */
@@ -364,6 +407,90 @@ OrbitOledClearBuffer()
 		*pb++ = 0x00;
 	}
 
+	OrbitOledMarkDirty(rgbOledBmp, cbOledDispMax);
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledUpdateAll
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Send the whole memory buffer to the display, whether it
+**		has changed or not.
+*/
+
+void
+OrbitOledUpdateAll()
+	{
+
+	OrbitOledMarkDirty(rgbOledBmp, cbOledDispMax);
+	OrbitOledUpdate();
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledMarkDirty
+**
+**	Parameters:
+**		pb		- first byte changed in the display buffer
+**		cb		- number of bytes changed
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Record that a run of bytes in the display buffer has
+**		changed, so the next update sends it. The run may cross
+**		page boundaries.
+*/
+
+void
+OrbitOledMarkDirty(char * pb, int cb)
+	{
+	int		ib;
+	int		ipag;
+	int		colLeft;
+	int		colRight;
+
+	ib = pb - rgbOledBmp;
+	if (cb <= 0 || ib < 0 || ib >= cbOledDispMax) {
+		return;
+	}
+	if (ib + cb > cbOledDispMax) {
+		cb = cbOledDispMax - ib;
+	}
+
+	while (cb > 0) {
+		ipag = ib / ccolOledMax;
+		colLeft = ib % ccolOledMax;
+		colRight = colLeft + cb - 1;
+		if (colRight >= ccolOledMax) {
+			colRight = ccolOledMax - 1;
+		}
+
+		if (colLeft < rgcolOledDirtyLeft[ipag]) {
+			rgcolOledDirtyLeft[ipag] = colLeft;
+		}
+		if (colRight > rgcolOledDirtyRight[ipag]) {
+			rgcolOledDirtyRight[ipag] = colRight;
+		}
+
+		cb -= colRight - colLeft + 1;
+		ib += colRight - colLeft + 1;
+	}
+
 }
 
 /* ------------------------------------------------------------ */
@@ -379,43 +506,347 @@ OrbitOledClearBuffer()
 **		none
 **
 **	Description:
-**		Update the OLED display with the contents of the memory buffer
+**		Update the OLED display with the contents of the memory buffer.
+**		Only the span of columns changed in each page since the last
+**		update is sent.
 */
 
 void
 OrbitOledUpdate()
 	{
 	int		ipag;
-//	int		icol;
+	int		colLeft;
+	int		ccol;
 	char *	pb;
 
-	pb = rgbOledBmp;
+	/* Let an asynchronous update finish first.
+	*/
+	while (stOledAsync != stOledAsyncIdle);
+
+	cbOledUpdateLast = 0;
 
 	for (ipag = 0; ipag < cpagOledMax; ipag++) {
 
+		colLeft = rgcolOledDirtyLeft[ipag];
+		ccol = rgcolOledDirtyRight[ipag] - colLeft + 1;
+		if (ccol <= 0) {
+			continue;
+		}
+
 		GPIOPinWrite(nDC_OLEDPort, nDC_OLED, LOW);
 
-		/* Set the page address
+		/* Set the page address. The controller is left in its
+		** reset default, page addressing mode, where the page is
+		** set by 0xB0 | page and the column by two nibbles.
 		*/
-		Ssi3PutByte(0x22);		//Set page command
-		Ssi3PutByte(ipag);		//page number
+		Ssi3PutByte(0xB0 | ipag);		//set page start address
 
-		/* Start at the left column
+		/* Start at the left edge of the changed span.
 		*/
-		Ssi3PutByte(0x00);		//set low nibble of column
-		Ssi3PutByte(0x10);		//set high nibble of column
+		Ssi3PutByte(0x00 | (colLeft & 0x0F));	//set low nibble of column
+		Ssi3PutByte(0x10 | (colLeft >> 4));		//set high nibble of column
 
 		GPIOPinWrite(nDC_OLEDPort, nDC_OLED, nDC_OLED);
 
-		/* Copy this memory page of display data.
+		/* Copy the changed part of this memory page of display data.
 		*/
-		OrbitOledPutBuffer(ccolOledMax, pb);
-		pb += ccolOledMax;
+		pb = &rgbOledBmp[(ipag * ccolOledMax) + colLeft];
+		OrbitOledPutBuffer(ccol, pb);
+		cbOledUpdateLast += 3 + ccol;
+
+		rgcolOledDirtyLeft[ipag] = ccolOledMax;
+		rgcolOledDirtyRight[ipag] = -1;
 
 	}
 
 }
 
+/* ------------------------------------------------------------ */
+/***	OrbitOledAsyncInit
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Prepare uDMA channel chOledDma and the SSI3 interrupt for
+**		OrbitOledUpdateAsync. The uDMA controller must already be
+**		enabled with its control table installed. The caller should
+**		also set the SSI3 interrupt priority.
+*/
+
+void
+OrbitOledAsyncInit()
+	{
+
+	uDMAChannelAssign(UDMA_CH15_SSI3TX);
+	uDMAChannelAttributeDisable(chOledDma, UDMA_ATTR_ALL);
+	uDMAChannelControlSet(chOledDma | UDMA_PRI_SELECT,
+						  UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE |
+						  UDMA_ARB_4);
+
+	/* Make the transmit interrupt mean "FIFO empty and bus idle",
+	** which is when nDC and nCS may change.
+	*/
+	SSIDisable(SSI3_BASE);
+	HWREG(SSI3_BASE + SSI_O_CR1) |= SSI_CR1_EOT;
+	SSIEnable(SSI3_BASE);
+
+	stOledAsync = stOledAsyncIdle;
+	SSIIntRegister(SSI3_BASE, OrbitOledSsi3IntHandler);
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledUpdateAsync
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		1 if the update was started (or nothing had changed),
+**		0 if an update is already running
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Start sending the changed parts of the memory buffer to
+**		the display and return at once. The uDMA feeds the page
+**		data and the SSI3 interrupt steps from page to page.
+**		OrbitOledUpdateBusy reports when it is finished, and the
+**		function given to OrbitOledSetAsyncDone is called from the
+**		interrupt at the end.
+*/
+
+int
+OrbitOledUpdateAsync()
+	{
+	int		ipag;
+	int		ib;
+	int		ibLast;
+
+	if (stOledAsync != stOledAsyncIdle) {
+		return 0;
+	}
+
+	/* Take a copy of the changed spans and start afresh.
+	*/
+	for (ipag = 0; ipag < cpagOledMax; ipag++) {
+		rgcolOledTxLeft[ipag] = rgcolOledDirtyLeft[ipag];
+		rgcolOledTxRight[ipag] = rgcolOledDirtyRight[ipag];
+
+		ib = (ipag * ccolOledMax) + rgcolOledDirtyLeft[ipag];
+		ibLast = (ipag * ccolOledMax) + rgcolOledDirtyRight[ipag];
+		for ( ; ib <= ibLast; ib++) {
+			rgbOledTx[ib] = rgbOledBmp[ib];
+		}
+
+		rgcolOledDirtyLeft[ipag] = ccolOledMax;
+		rgcolOledDirtyRight[ipag] = -1;
+	}
+
+	stOledAsync = stOledAsyncCmd;
+	ipagOledAsync = 0;
+	OrbitOledAsyncStartPage();
+
+	return 1;
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledUpdateBusy
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		non-zero while an asynchronous update is running
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Report whether OrbitOledUpdateAsync is still sending.
+*/
+
+int
+OrbitOledUpdateBusy()
+	{
+
+	return stOledAsync != stOledAsyncIdle;
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledSetAsyncDone
+**
+**	Parameters:
+**		pfn		- function to call when an update finishes, or 0
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Set the completion callback for OrbitOledUpdateAsync. It
+**		runs in interrupt context.
+*/
+
+void
+OrbitOledSetAsyncDone(void (*pfn)())
+	{
+
+	pfnOledAsyncDone = pfn;
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledAsyncStartPage
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Send the commands for the next changed page, starting at
+**		ipagOledAsync, or finish the update if there are none. The
+**		three command bytes fit the SSI FIFO, so this never waits.
+*/
+
+void
+OrbitOledAsyncStartPage()
+	{
+	int		colLeft;
+
+	while (ipagOledAsync < cpagOledMax &&
+		   rgcolOledTxLeft[ipagOledAsync] > rgcolOledTxRight[ipagOledAsync]) {
+		ipagOledAsync++;
+	}
+
+	if (ipagOledAsync >= cpagOledMax) {
+		stOledAsync = stOledAsyncIdle;
+		if (pfnOledAsyncDone != 0) {
+			(*pfnOledAsyncDone)();
+		}
+		return;
+	}
+
+	colLeft = rgcolOledTxLeft[ipagOledAsync];
+
+	GPIOPinWrite(nDC_OLEDPort, nDC_OLED, LOW);
+	GPIOPinWrite(nCS_OLEDPort, nCS_OLED, LOW);
+
+	/* Same command sequence as OrbitOledUpdate.
+	*/
+	SSIDataPut(SSI3_BASE, 0xB0 | ipagOledAsync);
+	SSIDataPut(SSI3_BASE, 0x00 | (colLeft & 0x0F));
+	SSIDataPut(SSI3_BASE, 0x10 | (colLeft >> 4));
+
+	stOledAsync = stOledAsyncCmd;
+	SSIIntEnable(SSI3_BASE, SSI_TXFF);
+
+}
+
+/* ------------------------------------------------------------ */
+/***	OrbitOledSsi3IntHandler
+**
+**	Parameters:
+**		none
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Step an asynchronous update along. The transmit interrupt
+**		(end of transmission) marks the commands or data having
+**		left the FIFO; the uDMA done signal marks the page data
+**		having been handed to the FIFO.
+*/
+
+void
+OrbitOledSsi3IntHandler()
+	{
+	uint32_t	status;
+	uint32_t	bTmp;
+	int			ib;
+
+	status = SSIIntStatus(SSI3_BASE, true);
+	SSIIntClear(SSI3_BASE, status);
+
+	switch (stOledAsync) {
+		case stOledAsyncCmd:
+			if ((status & SSI_TXFF) == 0) {
+				break;
+			}
+
+			/* Commands are out: switch to data and let the uDMA
+			** feed the page.
+			*/
+			SSIIntDisable(SSI3_BASE, SSI_TXFF);
+			while (SSIDataGetNonBlocking(SSI3_BASE, &bTmp));
+			GPIOPinWrite(nDC_OLEDPort, nDC_OLED, nDC_OLED);
+
+			ib = (ipagOledAsync * ccolOledMax) + rgcolOledTxLeft[ipagOledAsync];
+			uDMAChannelTransferSet(chOledDma | UDMA_PRI_SELECT,
+								   UDMA_MODE_BASIC, &rgbOledTx[ib],
+								   (void *)(SSI3_BASE + SSI_O_DR),
+								   rgcolOledTxRight[ipagOledAsync] -
+								   rgcolOledTxLeft[ipagOledAsync] + 1);
+			stOledAsync = stOledAsyncData;
+			uDMAChannelEnable(chOledDma);
+			SSIDMAEnable(SSI3_BASE, SSI_DMA_TX);
+			break;
+
+		case stOledAsyncData:
+			if (uDMAChannelModeGet(chOledDma | UDMA_PRI_SELECT) != UDMA_MODE_STOP) {
+				break;
+			}
+
+			/* All in the FIFO: wait for it to empty.
+			*/
+			SSIDMADisable(SSI3_BASE, SSI_DMA_TX);
+			stOledAsync = stOledAsyncDrain;
+			SSIIntEnable(SSI3_BASE, SSI_TXFF);
+			break;
+
+		case stOledAsyncDrain:
+			if ((status & SSI_TXFF) == 0) {
+				break;
+			}
+
+			/* Page done: release the display and go on.
+			*/
+			SSIIntDisable(SSI3_BASE, SSI_TXFF);
+			while (SSIDataGetNonBlocking(SSI3_BASE, &bTmp));
+			GPIOPinWrite(nCS_OLEDPort, nCS_OLED, nCS_OLED);
+
+			ipagOledAsync++;
+			OrbitOledAsyncStartPage();
+			break;
+
+		default:
+			SSIIntDisable(SSI3_BASE, SSI_TXFF);
+			break;
+	}
+
+}
+
 /* ------------------------------------------------------------ */
 /***	OrbitOledPutBuffer
 **
@@ -430,7 +861,10 @@ OrbitOledUpdate()
 **		none
 **
 **	Description:
-**		Send the bytes specified in rgbTx to the slave 
+**		Send the bytes specified in rgbTx to the slave. The transmit
+**		FIFO is kept full so the bus never idles between bytes; the
+**		display sends nothing back, so received bytes are discarded
+**		as they arrive.
 */
 
 void
@@ -443,24 +877,22 @@ OrbitOledPutBuffer(int cb, char * rgbTx)
 	*/
 	GPIOPinWrite(nCS_OLEDPort, nCS_OLED, LOW);
 
-	/* Write/Read the data
+	/* Write the data. SSIDataPut only waits while the transmit
+	** FIFO is full.
 	*/
 	for (ib = 0; ib < cb; ib++) {
-		/* Wait for transmitter to be ready
-		*/
-		while (SSIBusy(SSI3_BASE));
-
-		/* Write the next transmit byte.
-		*/
 		SSIDataPut(SSI3_BASE, (uint32_t)*rgbTx++);
 
-		/* Wait for receive byte.
+		/* Keep the receive FIFO from overrunning.
 		*/
-		while (SSIBusy(SSI3_BASE));
-		SSIDataGet(SSI3_BASE, &bTmp);
-
+		while (SSIDataGetNonBlocking(SSI3_BASE, &bTmp));
 	}
 
+	/* Wait for the last byte to leave before releasing the slave.
+	*/
+	while (SSIBusy(SSI3_BASE));
+	while (SSIDataGetNonBlocking(SSI3_BASE, &bTmp));
+
 	/* Bring the slave select line high
 	*/
 	GPIOPinWrite(nCS_OLEDPort, nCS_OLED, nCS_OLED);
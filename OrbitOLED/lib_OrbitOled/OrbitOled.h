@@ -42,6 +42,10 @@
 #define	modOledAnd		2
 #define	modOledXor		3
 
+/* uDMA channel for asynchronous updates (SSI3 TX)
+*/
+#define	chOledDma		15
+
 /* ------------------------------------------------------------ */
 /*					General Type Declarations					*/
 /* ------------------------------------------------------------ */
@@ -66,6 +70,12 @@ void	OrbitOledInit();
 void	OrbitOledClear();
 void	OrbitOledClearBuffer();
 void	OrbitOledUpdate();
+void	OrbitOledUpdateAll();
+void	OrbitOledAsyncInit();
+int		OrbitOledUpdateAsync();
+int		OrbitOledUpdateBusy();
+void	OrbitOledSetAsyncDone(void (*pfn)());
+void	OrbitOledMarkDirty(char * pb, int cb);
 
 /* ------------------------------------------------------------ */
 
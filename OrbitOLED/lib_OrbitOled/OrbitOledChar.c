@@ -23,6 +23,8 @@
 /*				Include File Definitions						*/
 /* ------------------------------------------------------------ */
 
+#include <string.h>
+
 #include "LaunchPad.h"
 #include "OrbitBoosterPackDefs.h"
 #include "OrbitOled.h"
@@ -51,7 +53,7 @@ extern char		rgbOledBmp[];
 extern int		dxcoOledFontCur;
 extern int		dycoOledFontCur;
 
-extern	char *	pbOledFontCur;
+extern	const char *	pbOledFontCur;
 extern	char *	pbOledFontUser;
 
 /* ------------------------------------------------------------ */
@@ -66,6 +68,9 @@ int		ychOledMax;
 
 char *	pbOledFontExt;
 
+/* User glyphs are defined at run time, so they stay in RAM.
+*/
+#pragma DATA_ALIGN(rgbOledFontUser, 4)
 char	rgbOledFontUser[cbOledFontUser];
 
 /* ------------------------------------------------------------ */
@@ -299,6 +304,48 @@ OrbitOledPutString(char * sz)
 
 }
 
+/* ------------------------------------------------------------ */
+/***	OrbitOledPutStringFast
+**
+**	Parameters:
+**		sz		- pointer to the null terminated string
+**
+**	Return Value:
+**		none
+**
+**	Errors:
+**		none
+**
+**	Description:
+**		Same as OrbitOledPutString, but steps the buffer address
+**		along the line itself instead of recomputing it from the
+**		cursor after every character. The full cursor update is
+**		only done when the string wraps to the next line.
+*/
+
+void
+OrbitOledPutStringFast(char * sz)
+	{
+
+	while (*sz != '\0') {
+		OrbitOledDrawGlyph(*sz);
+		if (xchOledCur < xchOledMax - 1) {
+			xchOledCur += 1;
+			xcoOledCur += dxcoOledFontCur;
+			pbOledCur += dxcoOledFontCur;
+		}
+		else {
+			OrbitOledAdvanceCursor();
+		}
+		sz += 1;
+	}
+
+	if (fOledCharUpdate) {
+		OrbitOledUpdate();
+	}
+
+}
+
 /* ------------------------------------------------------------ */
 /***	OrbitOledDrawGlyph
 **
@@ -316,14 +363,19 @@ OrbitOledPutString(char * sz)
 **		at the current character cursor location. This does not
 **		affect the current character cursor location or the 
 **		current drawing position in the display buffer.
+**		When the glyph is 8 columns wide it is copied and compared
+**		as two 32 bit words, moved through memcpy so the font and
+**		buffer are never read through a uint32_t pointer.
 */
 
 void
 OrbitOledDrawGlyph(char ch)
 	{
-	char *	pbFont;
+	const char *	pbFont;
 	char *	pbBmp;
 	int		ib;
+	uint32_t	wFont;
+	uint32_t	wBmp;
 
 	if ((ch & 0x80) != 0) {
 		return;
@@ -338,8 +390,28 @@ OrbitOledDrawGlyph(char ch)
 
 	pbBmp = pbOledCur;
 
+	if (dxcoOledFontCur == 8) {
+		for (ib = 0; ib < 8; ib += 4) {
+			memcpy(&wFont, pbFont + ib, 4);
+			memcpy(&wBmp, pbBmp + ib, 4);
+			if (wBmp != wFont) {
+				memcpy(pbBmp + ib, &wFont, 4);
+				OrbitOledMarkDirty(pbBmp + ib, 4);
+			}
+		}
+		return;
+	}
+
+	/* Only mark the columns that actually change, so redrawing the
+	** same text costs nothing at the next update.
+	*/
 	for (ib = 0; ib < dxcoOledFontCur; ib++) {
-		*pbBmp++ = *pbFont++;
+		if (*pbBmp != *pbFont) {
+			*pbBmp = *pbFont;
+			OrbitOledMarkDirty(pbBmp, 1);
+		}
+		pbBmp++;
+		pbFont++;
 	}
 
 }
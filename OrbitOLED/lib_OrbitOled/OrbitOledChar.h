@@ -54,6 +54,7 @@ void	OrbitOledSetCharUpdate(int f);
 int		OrbitOledGetCharUpdate();
 void	OrbitOledPutChar(char ch);
 void	OrbitOledPutString(char * sz);
+void	OrbitOledPutStringFast(char * sz);
 
 /* ------------------------------------------------------------ */
 
@@ -46,7 +46,7 @@ extern int		bnOledCur;
 extern char		clrOledCur;
 extern char *	pbOledPatCur;
 extern char	*	pbOledFontUser;
-extern char *	pbOledFontCur;
+extern const char *	pbOledFontCur;
 extern int		dxcoOledFontCur;
 extern int		dycoOledFontCur;
 
@@ -305,6 +305,7 @@ OrbitOledDrawPixel()
 	{
 
 	*pbOledCur = (*pfnDoRop)((clrOledCur << bnOledCur), *pbOledCur, (1<<bnOledCur));
+	OrbitOledMarkDirty(pbOledCur, 1);
 
 }
 
@@ -568,6 +569,8 @@ OrbitOledFillRect(int xco, int yco)
 			}
 		}
 
+		OrbitOledMarkDirty(pbLeft, xcoRight - xcoLeft + 1);
+
 		/* Advance to the next horizontal stripe.
 		*/
 		ycoTop = 8*((ycoTop/8)+1);
@@ -699,7 +702,7 @@ OrbitOledGetBmp(int dxco, int dyco, char * pbBits)
 */
 
 void
-OrbitOledPutBmp(int dxco, int dyco, char * pbBits)
+OrbitOledPutBmp(int dxco, int dyco, const char * pbBits)
 	{
 	int		xcoLeft;
 	int		xcoRight;
@@ -707,8 +710,8 @@ OrbitOledPutBmp(int dxco, int dyco, char * pbBits)
 	int		ycoBottom;
 	char *	pbDspCur;
 	char *	pbDspLeft;
-	char *	pbBmpCur;
-	char *	pbBmpLeft;
+	const char *	pbBmpCur;
+	const char *	pbBmpLeft;
 	int		xcoCur;
 	char	bBmp;
 	char	mskEnd;
@@ -783,6 +786,8 @@ OrbitOledPutBmp(int dxco, int dyco, char * pbBits)
 			}
 		}
 
+		OrbitOledMarkDirty(pbDspLeft, xcoRight - xcoLeft);
+
 		/* Advance to the next horizontal stripe.
 		*/
 		ycoTop = 8*((ycoTop/8)+1);
@@ -814,7 +819,7 @@ OrbitOledPutBmp(int dxco, int dyco, char * pbBits)
 void
 OrbitOledDrawChar(char ch)
 	{
-	char *	pbFont;
+	const char *	pbFont;
 	char *	pbBmp;
 
 	if ((ch & 0x80) != 0) {
@@ -59,7 +59,7 @@ void	OrbitOledLineTo(int xco, int yco);
 void	OrbitOledDrawRect(int xco, int yco);
 void	OrbitOledFillRect(int xco, int yco);
 void	OrbitOledGetBmp(int dxco, int dyco, char * pbBmp);
-void	OrbitOledPutBmp(int dxco, int dyco, char * pbBmp);
+void	OrbitOledPutBmp(int dxco, int dyco, const char * pbBmp);
 void	OrbitOledDrawChar(char ch);
 void	OrbitOledDrawString(char * sz);
 
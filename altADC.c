@@ -9,6 +9,7 @@
 #include <stdbool.h>
 
 #include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
 
 #include "driverlib/adc.h"
 #include "driverlib/sysctl.h"
@@ -17,6 +18,8 @@
 #include "circBufT.h"
 
 #include "altADC.h"
+#include "intPriority.h"
+#include "isrTiming.h"
 //
 
 #define BUF_SIZE            10
@@ -33,6 +36,7 @@ static uint16_t g_buffer_values;
 void ADCIntHandler(void)
 {
 
+    uint32_t start = isrTimingStart();
     uint32_t ulValue;
 
     //
@@ -46,6 +50,8 @@ void ADCIntHandler(void)
     //
     // Clean up, clearing the interrupt
     ADCIntClear(ADC0_BASE, 3);
+
+    isrTimingEnd(ISR_ADC, start);
 }
 
 // Initialize the ADC module
@@ -78,6 +84,7 @@ void initADC(void)
     //
     // Register the interrupt handler
     ADCIntRegister(ADC0_BASE, 3, ADCIntHandler);
+    IntPrioritySet(INT_ADC0SS3, INT_PRIORITY_ADC);
 
     //
     // Enable interrupts for ADC0 sequence 3 (clears any outstanding interrupts)
@@ -118,6 +125,25 @@ void updateAlt(void)
         }
 }
 
+// Variance of the raw samples in the circular buffer (ADC counts
+// squared), as a measure of altitude signal noise. Reads the entries
+// in place: readCircBuf() would move the read index updateAlt() uses.
+uint32_t getAltVariance(void)
+{
+    int32_t sum = 0;
+    uint32_t sumSq = 0;
+    int32_t sample;
+    uint16_t i;
+
+    for (i = 0; i < BUF_SIZE; i++) {
+        sample = g_inBuffer.data[i];
+        sum += sample;
+        sumSq += sample * sample;
+    }
+
+    return (sumSq - (uint32_t)(sum * sum) / BUF_SIZE) / BUF_SIZE;
+}
+
 // Trigget the ADC to run when the SysTick interrupt runs
 void triggerADC(void)
 {
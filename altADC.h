@@ -14,6 +14,10 @@ void initADC(void);
 // Average the data in the circular buffer to calculate altitude
 void updateAlt(void);
 
+// Variance of the raw samples in the circular buffer (ADC counts
+// squared), as a measure of altitude signal noise
+uint32_t getAltVariance(void);
+
 // Trigget the ADC to run when the SysTick interrupt runs
 void triggerADC(void);
 
@@ -27,6 +27,7 @@
 #include "driverlib/debug.h"
 
 #include "buttons4.h"
+#include "fastGPIO.h"
 
 
 // *******************************************************
@@ -125,10 +126,10 @@ updateButtons (void)
 	int i;
 
 	// Read the pins; true means HIGH, false means LOW
-	but_value[UP] = (GPIOPinRead (UP_BUT_PORT_BASE, UP_BUT_PIN) == UP_BUT_PIN);
-	but_value[DOWN] = (GPIOPinRead (DOWN_BUT_PORT_BASE, DOWN_BUT_PIN) == DOWN_BUT_PIN);
-    but_value[LEFT] = (GPIOPinRead (LEFT_BUT_PORT_BASE, LEFT_BUT_PIN) == LEFT_BUT_PIN);
-    but_value[RIGHT] = (GPIOPinRead (RIGHT_BUT_PORT_BASE, RIGHT_BUT_PIN) == RIGHT_BUT_PIN);
+	but_value[UP] = (fastGPIORead (UP_BUT_PORT_BASE, UP_BUT_PIN) == UP_BUT_PIN);
+	but_value[DOWN] = (fastGPIORead (DOWN_BUT_PORT_BASE, DOWN_BUT_PIN) == DOWN_BUT_PIN);
+    but_value[LEFT] = (fastGPIORead (LEFT_BUT_PORT_BASE, LEFT_BUT_PIN) == LEFT_BUT_PIN);
+    but_value[RIGHT] = (fastGPIORead (RIGHT_BUT_PORT_BASE, RIGHT_BUT_PIN) == RIGHT_BUT_PIN);
 //    but_value[RESET] = (GPIOPinRead (RESET_PORT_BASE, GPIO_PIN_6) == GPIO_PIN_6);
 
 	// Iterate through the buttons, updating button variables as required
@@ -175,7 +176,7 @@ uint8_t checkSwitch()
 {
     uint8_t switchState;
 
-    switchState = (GPIOPinRead(SW1_PORT_BASE, SW1_PIN) == SW1_PIN);
+    switchState = (fastGPIORead(SW1_PORT_BASE, SW1_PIN) == SW1_PIN);
 
     return switchState;
 }
@@ -0,0 +1,123 @@
+/*
+ * byteRing.h
+ *
+ * Single-producer, single-consumer byte ring, used for the UART
+ * transmit and receive buffers. Head and tail are free-running 16-bit
+ * counts and the ring holds head - tail bytes, so full and empty are
+ * told apart without a spare slot. Only the producer moves head and
+ * only the consumer moves tail, so one side can be an interrupt
+ * handler with no lock. The size must be a power of two, at most
+ * 32768.
+ *
+ * No hardware access; tests/test_byte_ring.c runs it on a PC.
+ */
+
+#ifndef BYTERING_H_
+#define BYTERING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    volatile char *data;
+    uint16_t mask;              // Size - 1
+    volatile uint16_t head;     // Next slot to fill, producer only
+    volatile uint16_t tail;     // Next byte to take, consumer only
+} byteRing_t;
+
+// Static initialiser for an empty ring over a char array
+#define BYTE_RING(array)        {(array), sizeof(array) - 1, 0, 0}
+
+// Attach storage of size bytes and empty the ring
+static inline void
+byteRingInit(byteRing_t *ring, char *data, uint16_t size)
+{
+    ring->data = data;
+    ring->mask = size - 1;
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+// Number of bytes waiting
+static inline uint16_t
+byteRingCount(const byteRing_t *ring)
+{
+    return (uint16_t)(ring->head - ring->tail);
+}
+
+static inline bool
+byteRingEmpty(const byteRing_t *ring)
+{
+    return ring->head == ring->tail;
+}
+
+static inline bool
+byteRingFull(const byteRing_t *ring)
+{
+    return byteRingCount(ring) > ring->mask;
+}
+
+// Producer: add one byte. Returns false, leaving the ring as it was,
+// if it is full.
+static inline bool
+byteRingPut(byteRing_t *ring, char c)
+{
+    uint16_t head = ring->head;
+
+    if ((uint16_t)(head - ring->tail) > ring->mask) {
+        return false;
+    }
+
+    ring->data[head & ring->mask] = c;
+    ring->head = head + 1;
+    return true;
+}
+
+// Consumer: take one byte. Returns false if the ring is empty.
+static inline bool
+byteRingGet(byteRing_t *ring, char *c)
+{
+    uint16_t tail = ring->tail;
+
+    if (tail == ring->head) {
+        return false;
+    }
+
+    *c = ring->data[tail & ring->mask];
+    ring->tail = tail + 1;
+    return true;
+}
+
+// Producer: add up to len bytes. Returns the number accepted.
+static inline uint16_t
+byteRingWrite(byteRing_t *ring, const char *src, uint16_t len)
+{
+    uint16_t head = ring->head;
+    uint16_t accepted = 0;
+
+    while (accepted < len && (uint16_t)(head - ring->tail) <= ring->mask) {
+        ring->data[head & ring->mask] = src[accepted++];
+        head++;
+    }
+    ring->head = head;
+
+    return accepted;
+}
+
+// Consumer: take up to max bytes. Returns the number read.
+static inline uint16_t
+byteRingRead(byteRing_t *ring, char *dst, uint16_t max)
+{
+    uint16_t tail = ring->tail;
+    uint16_t count = 0;
+
+    while (count < max && tail != ring->head) {
+        dst[count++] = ring->data[tail & ring->mask];
+        tail++;
+    }
+    ring->tail = tail;
+
+    return count;
+}
+
+#endif /* BYTERING_H_ */
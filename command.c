@@ -0,0 +1,388 @@
+/*
+ * command.c
+ *
+ * Command channel on the UART. Received bytes are assembled into lines
+ * and each complete line is acted on. See command.h for the commands.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stdlib.h"
+#include "string.h"
+
+#include "command.h"
+#include "uart.h"
+#include "control.h"
+#include "telemetry.h"
+#include "yawDetection.h"
+#include "numFormat.h"
+#include "recorder.h"
+#include "flashLog.h"
+#include "display.h"
+#include "isrTiming.h"
+#include "stackUsage.h"
+#include "pwmControl.h"
+#include "uartDma.h"
+
+//**********************************************************************
+// Constants
+//**********************************************************************
+#define COMMAND_LINE_MAX            32
+#define COMMAND_BAUD_CONFIRM_TICKS  200     // 2 s at the 100 Hz SysTick
+#define COMMAND_GAIN_SCALE          1000000.0f  // Gains are sent in millionths
+
+enum linkStates {LINK_IDLE = 0, LINK_CONFIRMING};
+
+//**********************************************************************
+// Globals to module
+//**********************************************************************
+static char g_line[COMMAND_LINE_MAX + 1];
+static uint8_t g_lineLen;
+static bool g_lineOverflow;             // Discard the rest of an over-long line
+
+static uint8_t g_linkState = LINK_IDLE;
+static uint32_t g_linkDeadline;         // SysTick count to give up at
+static uint32_t g_linkPrevBaud;         // Rate to fall back to
+
+static volatile bool g_flying;          // ALT and YAW are taken only while flying
+static volatile bool g_cmdPending[NUM_CMDS];
+static volatile int32_t g_cmdValue[NUM_CMDS];
+
+// Send a one-line reply
+static void
+reply(const char *text, int32_t value)
+{
+    char str[COMMAND_LINE_MAX];
+    char *p;
+
+    p = fmtStr(str, text);
+    p = fmtStr(p, " ");
+    p = fmtInt(p, value, 0);
+    fmtStr(p, "\r\n");
+    UARTSend(str);
+}
+
+// Send a one-line refusal naming the command, the first word of text.
+// The rest of the line isn't echoed.
+static void
+refuse(const char *text)
+{
+    char str[COMMAND_LINE_MAX + 8];
+    char *p;
+    uint8_t len = 0;
+
+    p = fmtStr(str, "NAK ");
+    while (text[len] != '\0' && text[len] != ' ' && len < COMMAND_LINE_MAX) {
+        *p++ = text[len++];
+    }
+    fmtStr(p, "\r\n");
+    UARTSend(str);
+}
+
+// Parse a whole signed decimal argument. Returns false on an empty
+// argument or trailing junk.
+static bool
+parseInt(const char *text, int32_t *value)
+{
+    char *end;
+
+    *value = strtol(text, &end, 10);
+    return end != text && *end == '\0';
+}
+
+// Queue a command for the main loop
+static void
+post(uint8_t cmd, int32_t value)
+{
+    g_cmdValue[cmd] = value;
+    g_cmdPending[cmd] = true;
+}
+
+// SUB <channel> <decimation>
+static bool
+handleSubscribe(const char *args)
+{
+    int32_t channel;
+    int32_t decimation;
+    char *end;
+
+    channel = strtol(args, &end, 10);
+    if (end == args || *end != ' ' || channel < 0 || channel > 0xFF) {
+        return false;
+    }
+
+    if (!parseInt(end + 1, &decimation) || decimation < 0 || decimation > 0xFF
+        || !telemetrySubscribe(channel, decimation)) {
+        return false;
+    }
+
+    reply("ACK SUB", channel);
+    return true;
+}
+
+// GAIN <ALT|YAW> <P|I|D> <ugain>
+static bool
+handleGain(const char *args)
+{
+    float gains[3];
+    int32_t value;
+    uint8_t term;
+    bool alt;
+
+    if (strncmp(args, "ALT ", 4) == 0) {
+        alt = true;
+    }
+    else if (strncmp(args, "YAW ", 4) == 0) {
+        alt = false;
+    }
+    else {
+        return false;
+    }
+
+    switch (args[4]) {
+        case 'P': term = 0; break;
+        case 'I': term = 1; break;
+        case 'D': term = 2; break;
+        default: return false;
+    }
+
+    if (args[5] != ' ' || !parseInt(args + 6, &value) || value < 0) {
+        return false;
+    }
+
+    if (alt) {
+        getAltGains(&gains[0], &gains[1], &gains[2]);
+        gains[term] = value / COMMAND_GAIN_SCALE;
+        setAltGains(gains[0], gains[1], gains[2]);
+    }
+    else {
+        getYawGains(&gains[0], &gains[1], &gains[2]);
+        gains[term] = value / COMMAND_GAIN_SCALE;
+        setYawGains(gains[0], gains[1], gains[2]);
+    }
+
+    reply("ACK GAIN", value);
+    return true;
+}
+
+// Act on one complete line
+static void
+handleLine(char *line, uint32_t ticks)
+{
+    uint32_t baud;
+    int32_t value;
+
+    if (strncmp(line, "BAUD ", 5) == 0) {
+        baud = strtoul(line + 5, 0, 10);
+        if (g_linkState != LINK_IDLE || !uartSetBaud(baud)) {
+            reply("NAK BAUD", baud);
+            return;
+        }
+
+        // uartSetBaud() holds the switch until this reply has gone out
+        g_linkPrevBaud = uartGetBaud();
+        reply("ACK", baud);
+        g_linkState = LINK_CONFIRMING;
+        g_linkDeadline = ticks + COMMAND_BAUD_CONFIRM_TICKS;
+    }
+    else if (strcmp(line, "OK") == 0 && g_linkState == LINK_CONFIRMING) {
+        g_linkState = LINK_IDLE;
+        reply("READY", uartGetBaud());
+    }
+    else if (strncmp(line, "ALT ", 4) == 0) {
+        if (!g_flying || !parseInt(line + 4, &value) || value < 0 || value > 100) {
+            refuse("ALT");
+            return;
+        }
+        post(CMD_ALT, value);
+        reply("ACK ALT", value);
+    }
+    else if (strncmp(line, "YAW ", 4) == 0) {
+        if (!g_flying || !parseInt(line + 4, &value)) {
+            refuse("YAW");
+            return;
+        }
+        value = wrapYaw(value);
+        post(CMD_YAW, value);
+        reply("ACK YAW", value);
+    }
+    else if (strncmp(line, "GAIN ", 5) == 0) {
+        if (!handleGain(line + 5)) {
+            refuse("GAIN");
+        }
+    }
+    else if (strncmp(line, "RATE ", 5) == 0) {
+        if (!parseInt(line + 5, &value) || value < 0 || value > 0xFFFF
+            || !setTelemetryRate(value)) {
+            refuse("RATE");
+            return;
+        }
+        reply("ACK RATE", value);
+    }
+    else if (strcmp(line, "TEL TEXT") == 0) {
+        setTelemetryMode(TELEMETRY_TEXT);
+        reply("ACK TEL", TELEMETRY_TEXT);
+    }
+    else if (strcmp(line, "TEL BIN") == 0) {
+        setTelemetryMode(TELEMETRY_BINARY);
+        reply("ACK TEL", TELEMETRY_BINARY);
+    }
+    else if (strcmp(line, "TEL CH") == 0) {
+        setTelemetryMode(TELEMETRY_CHANNELS);
+        reply("ACK TEL", TELEMETRY_CHANNELS);
+    }
+    else if (strcmp(line, "REC FREEZE") == 0) {
+        recorderFreeze(REC_CAUSE_COMMAND);
+        reply("ACK REC", getRecorderCause());
+    }
+    else if (strcmp(line, "REC DUMP") == 0) {
+        recorderStartDump();
+        reply("ACK REC", getRecorderCause());
+    }
+    else if (strcmp(line, "REC CLEAR") == 0) {
+        recorderClear();
+        reply("ACK REC", getRecorderCause());
+    }
+    else if (strcmp(line, "LOG DUMP") == 0) {
+        flashLogStartDump();
+        reply("ACK LOG", flashLogDropped());
+    }
+    else if (strcmp(line, "LOG CLEAR") == 0) {
+        flashLogClear();
+        reply("ACK LOG", 0);
+    }
+    else if (strcmp(line, "UART RX") == 0) {
+        reply("ACK UART", uartRxDropped());
+    }
+    else if (strcmp(line, "UART TX") == 0) {
+        reply("ACK UART", uartTxDropped());
+    }
+    else if (strcmp(line, "UART DMA") == 0) {
+        reply("ACK UART", uartDmaDropped());
+    }
+    else if (strcmp(line, "REF DRIFT") == 0) {
+        reply("ACK REF", getYawRefDrift());
+    }
+    else if (strcmp(line, "REF DRIFT MAX") == 0) {
+        reply("ACK REF", getYawRefDriftMax());
+    }
+    else if (strncmp(line, "TIME RUN ", 9) == 0) {
+        if (!parseInt(line + 9, &value) || value < 0 || value >= NUM_ISRS) {
+            refuse("TIME");
+            return;
+        }
+        reply("ACK TIME", getISRMaxRunCycles(value));
+    }
+    else if (strcmp(line, "TIME LATENCY") == 0) {
+        reply("ACK TIME", getSysTickMaxLatency());
+    }
+    else if (strcmp(line, "TIME LOOP") == 0) {
+        reply("ACK TIME", getLoopMaxCycles());
+    }
+    else if (strcmp(line, "TIME PWM") == 0) {
+        reply("ACK TIME", getPWMStartSkew());
+    }
+    else if (strcmp(line, "STACK") == 0) {
+        reply("ACK STACK", getStackUsed());
+    }
+    else if (strcmp(line, "BENCH GPIO") == 0) {
+        reply("ACK BENCH", benchYawGPIO(true));
+    }
+    else if (strcmp(line, "BENCH GPIO LIB") == 0) {
+        reply("ACK BENCH", benchYawGPIO(false));
+    }
+    else if (strcmp(line, "BENCH OLED") == 0) {
+        reply("ACK BENCH", benchDisplayUpdate());
+    }
+    else if (strcmp(line, "BENCH TEXT") == 0) {
+        reply("ACK BENCH", benchDisplayText());
+    }
+    else if (strcmp(line, "BENCH PWM") == 0) {
+        reply("ACK BENCH", benchRotorUpdate(true));
+    }
+    else if (strcmp(line, "BENCH PWM WRITE") == 0) {
+        reply("ACK BENCH", benchRotorUpdate(false));
+    }
+    else if (strcmp(line, "BENCH FMT") == 0) {
+        reply("ACK BENCH", benchDisplayFormat(true));
+    }
+    else if (strcmp(line, "BENCH FMT LIB") == 0) {
+        reply("ACK BENCH", benchDisplayFormat(false));
+    }
+    else if (strncmp(line, "SUB ", 4) == 0) {
+        if (!handleSubscribe(line + 4)) {
+            refuse("SUB");
+        }
+    }
+    else if (strcmp(line, "MODE FLY") == 0) {
+        post(CMD_MODE, CMD_MODE_FLY);
+        reply("ACK MODE", CMD_MODE_FLY);
+    }
+    else if (strcmp(line, "MODE LAND") == 0) {
+        post(CMD_MODE, CMD_MODE_LAND);
+        reply("ACK MODE", CMD_MODE_LAND);
+    }
+    else {
+        refuse(line);
+    }
+}
+
+// Read and act on any received commands
+void commandPoll(uint32_t ticks)
+{
+    char buf[16];
+    uint16_t count;
+    uint16_t i;
+
+    uartPoll();
+
+    // Host never confirmed the new rate -- fall back
+    if (g_linkState == LINK_CONFIRMING && (int32_t)(ticks - g_linkDeadline) >= 0) {
+        uartSetBaud(g_linkPrevBaud);
+        g_linkState = LINK_IDLE;
+    }
+
+    while ((count = uartRead(buf, sizeof(buf))) > 0) {
+        for (i = 0; i < count; i++) {
+            char c = buf[i];
+
+            if (c == '\r' || c == '\n') {
+                if (g_lineLen > 0 && !g_lineOverflow) {
+                    g_line[g_lineLen] = '\0';
+                    handleLine(g_line, ticks);
+                }
+                g_lineLen = 0;
+                g_lineOverflow = false;
+            }
+            else if (g_lineLen < COMMAND_LINE_MAX) {
+                g_line[g_lineLen++] = c;
+            }
+            else {
+                g_lineOverflow = true;
+            }
+        }
+    }
+}
+
+// Set whether ALT and YAW are accepted; stopping drops any queued
+void setCommandFlying(bool flying)
+{
+    if (!flying) {
+        g_cmdPending[CMD_ALT] = false;
+        g_cmdPending[CMD_YAW] = false;
+    }
+    g_flying = flying;
+}
+
+// Hand a queued command to the main loop
+bool checkCommand(uint8_t cmd, int32_t *value)
+{
+    if (cmd >= NUM_CMDS || !g_cmdPending[cmd]) {
+        return false;
+    }
+
+    g_cmdPending[cmd] = false;
+    *value = g_cmdValue[cmd];
+    return true;
+}
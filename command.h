@@ -0,0 +1,87 @@
+/*
+ * command.h
+ *
+ * Command channel on the UART. Commands are ASCII lines ending in CR
+ * or LF; each gets a one-line reply.
+ *
+ *   BAUD <rate>   Change the link rate. Replies "ACK <rate>" at the old
+ *                 rate, then switches. The host must switch too and
+ *                 send "OK" within COMMAND_BAUD_CONFIRM_TICKS, or the
+ *                 link falls back to the old rate.
+ *   OK            Confirm a baud change. Replies "READY <rate>".
+ *   ALT <pct>     Altitude target, 0 to 100 %. Only while flying.
+ *   YAW <deg>     Yaw target in degrees, wrapped to [-180, 180). Only
+ *                 while flying.
+ *   GAIN <ALT|YAW> <P|I|D> <ugain>
+ *                 Set one PID gain, in millionths (1500 = 0.0015).
+ *   RATE <hz>     Binary telemetry frame rate; must divide 100.
+ *   TEL <TEXT|BIN|CH>  Telemetry format: text, fixed frames or
+ *                 subscribed channels.
+ *   SUB <id> <n>  Send channel id (enum telemetryChannels) in every
+ *                 n'th frame; n = 0 unsubscribes.
+ *   MODE <FLY|LAND>  Same as raising or lowering the mode switch.
+ *   REC <FREEZE|DUMP|CLEAR>  Stop the flight recorder, dump it as
+ *                 binary frames, or discard it and record again.
+ *                 Replies with the freeze cause (recorder.h).
+ *   LOG <DUMP|CLEAR>  Dump the flash log as binary frames, or erase
+ *                 it once the motors are off. DUMP replies with the
+ *                 number of blocks the log has dropped.
+ *   UART <RX|TX|DMA>  Bytes lost to a full receive or transmit
+ *                 buffer, or binary frames dropped for want of a free
+ *                 DMA buffer, since reset.
+ *   REF DRIFT [MAX]  Encoder count error measured at the last yaw
+ *                 reference edge, or the largest magnitude seen with
+ *                 MAX. Nonzero means encoder counts are being missed.
+ *   TIME RUN <id> Longest run of ISR id (enum isrIds) in CPU cycles.
+ *   TIME LATENCY  Longest SysTick entry latency in CPU cycles.
+ *   TIME LOOP     Longest main loop pass in CPU cycles.
+ *   TIME PWM      CPU cycles between the main and tail PWM counters
+ *                 starting; their phase offset.
+ *   STACK         Deepest stack use since reset in bytes, out of
+ *                 the 2 kB stack (see intPriority.h).
+ *   BENCH GPIO [LIB]  Time the yaw ISR's pin clear and read through
+ *                 fastGPIO.h, or through driverlib with LIB. Replies
+ *                 "ACK BENCH <cycles per pass>".
+ *   BENCH OLED    Time a full-frame display update. Replies
+ *                 "ACK BENCH <cycles>" (20 cycles per us). Blocks
+ *                 for the update.
+ *   BENCH TEXT    Time drawing text into the display buffer. Replies
+ *                 "ACK BENCH <cycles per character>".
+ *   BENCH PWM [WRITE]  Time setRotorPermille() and the control tick's
+ *                 compare writes, skipping unchanged compares, or
+ *                 writing them every pass with WRITE. Replies
+ *                 "ACK BENCH <cycles per pass>".
+ *   BENCH FMT [LIB]  Time formatting a display line with numFormat.h,
+ *                 or with usnprintf() with LIB. Replies
+ *                 "ACK BENCH <cycles per line>".
+ *
+ * Accepted commands reply "ACK <command> <value>"; anything else gets
+ * "NAK <command>". ALT, YAW and MODE are queued for the main loop to
+ * pick up with checkCommand(). MODE is taken in any mode. ALT and YAW
+ * are refused unless the main loop has reported FLYING with
+ * setCommandFlying(), and any still queued are dropped when it stops
+ * flying, so a target sent on the ground never applies at take-off.
+ */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+enum commandIds {CMD_ALT = 0, CMD_YAW, CMD_MODE, NUM_CMDS};
+enum commandModes {CMD_MODE_FLY = 0, CMD_MODE_LAND};
+
+// Read and act on any received commands. Call every main loop pass
+// with the current SysTick count; never blocks.
+void commandPoll(uint32_t ticks);
+
+// Tell the command channel whether the heli is flying. Call every main
+// loop pass after the state machine.
+void setCommandFlying(bool flying);
+
+// Return true, once, if the command has been received since the last
+// call, and store its argument in *value. The latest one wins.
+bool checkCommand(uint8_t cmd, int32_t *value);
+
+#endif /* COMMAND_H_ */
@@ -2,19 +2,84 @@
 #include <stdint.h>
 
 #include "control.h"
+#include "yawDetection.h"
+
+// Output limits in permille of full scale. The terms are worked in
+// percent, so the sum is scaled by CONTROL_PERMILLE_PER_PCT.
+#define CONTROL_OUT_MIN             20
+#define CONTROL_OUT_MAX             980
+#define CONTROL_PERMILLE_PER_PCT    10
 
 static float I_alt = 0;
 static float error_previous_alt = 0;
 static float I_yaw = 0;
 static float error_previous_yaw = 0;
 
+// Terms from the latest update, for telemetry
+static float P_alt_last, D_alt_last;
+static float P_yaw_last, D_yaw_last;
+
+static float Kp_alt = 1.5;
+static float Ki_alt = 0.0015;
+static float Kd_alt = 0;
+
+static float Kp_yaw = 0.3;
+static float Ki_yaw = .0015;
+static float Kd_yaw = 0;
+
+void
+setAltGains(float Kp, float Ki, float Kd)
+{
+    Kp_alt = Kp;
+    Ki_alt = Ki;
+    Kd_alt = Kd;
+}
+
+void
+setYawGains(float Kp, float Ki, float Kd)
+{
+    Kp_yaw = Kp;
+    Ki_yaw = Ki;
+    Kd_yaw = Kd;
+}
+
+void
+getAltGains(float *Kp, float *Ki, float *Kd)
+{
+    *Kp = Kp_alt;
+    *Ki = Ki_alt;
+    *Kd = Kd_alt;
+}
+
+void
+getYawGains(float *Kp, float *Ki, float *Kd)
+{
+    *Kp = Kp_yaw;
+    *Ki = Ki_yaw;
+    *Kd = Kd_yaw;
+}
+
+void
+getAltTerms(float *P, float *I, float *D)
+{
+    *P = P_alt_last;
+    *I = I_alt;
+    *D = D_alt_last;
+}
+
+void
+getYawTerms(float *P, float *I, float *D)
+{
+    *P = P_yaw_last;
+    *I = I_yaw;
+    *D = D_yaw_last;
+}
+
 uint16_t
-alt_pid(int16_t current_alt, int16_t desired_alt, float dt)
+alt_pid(int16_t current_alt, int16_t desired_alt, float dt, bool limited)
 {
     uint16_t control_alt;
-    float Kp_alt = 1.5;
-    float Ki_alt = 0.0015;
-    float Kd_alt = 0;
+    float output_alt;
 
     float error_alt = desired_alt - current_alt;
     float P_alt = Kp_alt * error_alt;
@@ -23,20 +88,28 @@ alt_pid(int16_t current_alt, int16_t desired_alt, float dt)
 
     float D_alt = (Kd_alt / dt) * (error_alt - error_previous_alt);
 
-    control_alt = P_alt + (dI_alt + i_error_alt) + D_alt;
+    output_alt = (P_alt + (dI_alt + I_alt) + D_alt) * CONTROL_PERMILLE_PER_PCT;
+
+    P_alt_last = P_alt;
+    D_alt_last = D_alt;
 
     error_previous_alt = error_alt;
 
-    if (control_alt > 98) {
-        control_alt = 98;
+    // Clamp as a float; a negative float doesn't convert to unsigned
+    if (output_alt > CONTROL_OUT_MAX) {
+        control_alt = CONTROL_OUT_MAX;
     }
 
-    else if (control_alt < 2) {
-        control_alt = 2;
+    else if (output_alt < CONTROL_OUT_MIN) {
+        control_alt = CONTROL_OUT_MIN;
     }
 
+    // Don't wind up while the motor can't follow
     else {
-        I_alt += dI_alt;
+        control_alt = output_alt;
+        if (!limited) {
+            I_alt += dI_alt;
+        }
     }
 
     return control_alt;
@@ -45,34 +118,39 @@ alt_pid(int16_t current_alt, int16_t desired_alt, float dt)
 
 
 uint16_t
-yaw_pid(int32_t current_yaw, int32_t desired_yaw, float dt)
+yaw_pid(int32_t current_yaw, int32_t desired_yaw, float dt, bool limited)
 {
     uint16_t control_yaw; //value that is returned to the duty cycle
-    float Kp_yaw = 0.3;
-    float Ki_yaw = .0015;
-    float Kd_yaw = 0;
+    float output_yaw;
 
-    float error_yaw = desired_yaw - current_yaw;
+    // Take the short way round rather than unwinding whole turns
+    float error_yaw = yawError(desired_yaw, current_yaw);
     float P_yaw = Kp_yaw * error_yaw;
 
     float dI_yaw = Ki_yaw * error_yaw * dt;
 
     float D_yaw = (Kd_yaw / dt) * (error_yaw - error_previous_yaw);
 
-    control_yaw = P_yaw + (dI_yaw + i_error_yaw) + D_yaw;
+    output_yaw = (P_yaw + (dI_yaw + I_yaw) + D_yaw) * CONTROL_PERMILLE_PER_PCT;
+
+    P_yaw_last = P_yaw;
+    D_yaw_last = D_yaw;
 
     error_previous_yaw = error_yaw;
 
-    if (control_yaw > 98) {
-            control_yaw = 98;
+    if (output_yaw > CONTROL_OUT_MAX) {
+            control_yaw = CONTROL_OUT_MAX;
     }
 
-    else if (control_yaw < 2) {
-            control_yaw = 2;
+    else if (output_yaw < CONTROL_OUT_MIN) {
+            control_yaw = CONTROL_OUT_MIN;
     }
 
     else {
-        I_yaw += dI_yaw;
+        control_yaw = output_yaw;
+        if (!limited) {
+            I_yaw += dI_yaw;
+        }
     }
 
     return control_yaw;
@@ -9,15 +9,40 @@
 #define CONTROL_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 // *************************
 // alt_pid:
+// Returns the main rotor duty in permille (20 to 980)
+// limited - output is being held back by the actuator
+// (slew limit), so the integrator is frozen
 // *************************
-uint16_t alt_pid(int16_t current_alt, int16_t desired_alt, float dt);
+uint16_t alt_pid(int16_t current_alt, int16_t desired_alt, float dt, bool limited);
 
 // *************************
 // yaw_pid:
+// Returns the tail rotor duty in permille (20 to 980)
+// limited - as for alt_pid
 // *************************
-uint16_t yaw_pid(int32_t current_yaw, int32_t desired_yaw, float dt);
+uint16_t yaw_pid(int32_t current_yaw, int32_t desired_yaw, float dt, bool limited);
+
+// *************************
+// Gain setters/getters, for live tuning
+// *************************
+void setAltGains(float Kp, float Ki, float Kd);
+
+void setYawGains(float Kp, float Ki, float Kd);
+
+void getAltGains(float *Kp, float *Ki, float *Kd);
+
+void getYawGains(float *Kp, float *Ki, float *Kd);
+
+// *************************
+// Proportional, integral and derivative terms from the latest update,
+// in duty cycle %
+// *************************
+void getAltTerms(float *P, float *I, float *D);
+
+void getYawTerms(float *P, float *I, float *D);
 
 #endif /* CONTROL_H_ */
@@ -10,6 +10,7 @@
 
 #include "stdio.h"
 #include "stdlib.h"
+#include <string.h>
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
@@ -21,13 +22,186 @@
 
 #include "utils/ustdlib.h"
 #include "OrbitOLED/OrbitOLEDInterface.h"
+#include "OrbitOLED/lib_OrbitOled/OrbitOled.h"
+#include "OrbitOLED/lib_OrbitOled/OrbitOledChar.h"
 
 #include "display.h"
+#include "numFormat.h"
+#include "isrTiming.h"
+#include "intPriority.h"
+#include "dma.h"
+
+#define DISPLAY_BENCH_PASSES    64      // Fields formatted by benchDisplayFormat()
+
+// Values shown on the display. Labels and units are drawn once; each
+// value is redrawn only when it differs from what is on screen.
+enum displayFields {DISP_ALT = 0, DISP_YAW, DISP_MAIN, DISP_TAIL, NUM_DISPLAY_FIELDS};
+
+typedef struct {
+    const char *label;      // Drawn from column 0
+    const char *units;      // Drawn after the value
+    uint8_t row;            // Character row
+    uint8_t width;          // Characters reserved for the value
+} displayLayout_t;
+
+static const displayLayout_t g_displayLayout[NUM_DISPLAY_FIELDS] = {
+    {"Altitude: ", "%",    0, 4},   // DISP_ALT
+    {"YAW ",       " deg", 1, 4},   // DISP_YAW
+    {"Main DC: ",  "%",    2, 3},   // DISP_MAIN
+    {"Tail DC: ",  "%",    3, 3},   // DISP_TAIL
+};
+
+// Value last drawn in each field, and whether it has been drawn at all
+static int32_t g_displayValue[NUM_DISPLAY_FIELDS];
+static bool g_displayDrawn[NUM_DISPLAY_FIELDS];
+
+//*************************************************************************
+// Clamp value to the most that fits in width characters, so a wide
+// value can't overwrite the units or wrap onto the next row
+//*************************************************************************
+static int32_t
+clampToWidth(int32_t value, uint8_t width)
+{
+    int32_t limit = 1;
+    uint8_t i;
+
+    for (i = 0; i < width; i++) {
+        limit *= 10;
+    }
+
+    if (value > limit - 1) {
+        return limit - 1;
+    }
+    if (value < -(limit / 10 - 1)) {
+        return -(limit / 10 - 1);
+    }
+    return value;
+}
+
+//*************************************************************************
+// Draw one field's value if it has changed. Only the glyphs that differ
+// are marked dirty, so an unchanged field costs a compare.
+//*************************************************************************
+static void
+drawField(uint8_t field, int32_t value)
+{
+    const displayLayout_t *layout = &g_displayLayout[field];
+    char string[17]; // Display fits 16 characters wide.
+
+    value = clampToWidth(value, layout->width);
+    if (g_displayDrawn[field] && g_displayValue[field] == value) {
+        return;
+    }
+
+    fmtInt(string, value, layout->width);
+    OLEDStringDraw(string, strlen(layout->label), layout->row);
+
+    g_displayValue[field] = value;
+    g_displayDrawn[field] = true;
+}
+
+//*************************************************************************
+// Time one full-frame display update, in CPU cycles
+//*************************************************************************
+uint32_t benchDisplayUpdate(void)
+{
+    uint32_t start = isrTimingStart();
+
+    OrbitOledUpdateAll();
+
+    return isrTimingStart() - start;
+}
+
+//*************************************************************************
+// Draw the labels and units, with the values left blank until the next
+// update
+//*************************************************************************
+static void
+drawLabels(void)
+{
+    uint8_t field;
+    uint8_t i;
+    char string[17];
+    char *p;
+
+    for (field = 0; field < NUM_DISPLAY_FIELDS; field++) {
+        p = fmtStr(string, g_displayLayout[field].label);
+        for (i = 0; i < g_displayLayout[field].width; i++) {
+            *p++ = ' ';
+        }
+        fmtStr(p, g_displayLayout[field].units);
+        OLEDStringDraw(string, 0, g_displayLayout[field].row);
+
+        g_displayDrawn[field] = false;
+    }
+}
+
+//*************************************************************************
+// Time drawing text into the frame buffer, in CPU cycles per character.
+// Every glyph differs from the one it replaces, so this is the full
+// copy-and-mark cost. The flight display is put back afterwards.
+//*************************************************************************
+uint32_t benchDisplayText(void)
+{
+    uint32_t start = isrTimingStart();
+    uint32_t cycles;
+
+    OLEDStringDraw("0123456789ABCDEF", 0, 3);
+    OLEDStringDraw("FEDCBA9876543210", 0, 3);
+    cycles = isrTimingStart() - start;
+
+    drawLabels();
+
+    return cycles / 32;
+}
+
+//*************************************************************************
+// Time formatting the altitude line, in CPU cycles per line: through
+// numFormat.h, or through usnprintf() as the display did before. The
+// values mix signs and widths; loop overhead is included in both.
+//*************************************************************************
+uint32_t benchDisplayFormat(bool fast)
+{
+    char string[17];
+    char *p;
+    uint32_t start;
+    uint32_t cycles;
+    int32_t value;
+    uint8_t i;
+
+    start = isrTimingStart();
+    if (fast) {
+        for (i = 0; i < DISPLAY_BENCH_PASSES; i++) {
+            value = i * 37 - 1000;
+            p = fmtStr(string, "Altitude: ");
+            p = fmtInt(p, value, 4);
+            fmtStr(p, "%");
+        }
+    }
+    else {
+        for (i = 0; i < DISPLAY_BENCH_PASSES; i++) {
+            value = i * 37 - 1000;
+            usnprintf(string, sizeof(string), "Altitude: %4d%%", value);
+        }
+    }
+    cycles = isrTimingStart() - start;
+
+    return cycles / DISPLAY_BENCH_PASSES;
+}
 
 void initDisplay(void)
 {
     // intialise the Orbit OLED display
     OLEDInitialise();
+
+    // Refresh by uDMA from displayFlightData rather than after every
+    // string
+    initDMA();
+    OrbitOledAsyncInit();
+    IntPrioritySet(INT_SSI3, INT_PRIORITY_DISPLAY);
+    OrbitOledSetCharUpdate(0);
+
+    drawLabels();
 }
 
 //*************************************************************************
@@ -35,17 +209,12 @@ void initDisplay(void)
 //*************************************************************************
 void displayFlightData(int16_t altitude, uint16_t main_duty, uint16_t tail_duty, int16_t yaw_actual)
 {
-    char string[17]; // Display fits 16 characters wide.
-
-    usnprintf(string, sizeof(string), "Altitude: %4d%%", altitude);
-    OLEDStringDraw(string, 0, 0);
-
-    usnprintf(string, sizeof(string), "YAW %4d deg", yaw_actual);
-    OLEDStringDraw(string, 0, 1);
-
-    usnprintf(string, sizeof(string), "Main DC: %d%%", main_duty);
-    OLEDStringDraw(string, 0, 2);
+    drawField(DISP_ALT, altitude);
+    drawField(DISP_YAW, yaw_actual);
+    drawField(DISP_MAIN, main_duty);
+    drawField(DISP_TAIL, tail_duty);
 
-    usnprintf(string, sizeof(string), "Tail DC: %d%%", tail_duty);
-    OLEDStringDraw(string, 0, 3);
+    // Send the changes in the background. If the last refresh is still
+    // going, these changes wait for the next call.
+    OrbitOledUpdateAsync();
 }
@@ -12,4 +12,14 @@ void initDisplay(void);
 
 void displayFlightData(int16_t altitude, uint16_t main_duty, uint16_t tail_duty, int16_t yaw_actual);
 
+// Time one full-frame display update, in CPU cycles
+uint32_t benchDisplayUpdate(void);
+
+// Time drawing text into the frame buffer, in CPU cycles per character
+uint32_t benchDisplayText(void);
+
+// Time formatting one display line, in CPU cycles per line, with
+// numFormat.h if fast is true or usnprintf() otherwise
+uint32_t benchDisplayFormat(bool fast);
+
 #endif /* DISPLAY_H_ */
@@ -0,0 +1,37 @@
+/*
+ * dma.c
+ *
+ * Shared uDMA controller setup.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+#include "dma.h"
+
+// Channel control table. The controller needs it 1024-byte aligned.
+// Only primary entries are used, and no channel above 15, so the
+// alternate half of the table is not allocated.
+#define DMA_CHANNELS_USED       16
+
+#pragma DATA_ALIGN(g_dmaControlTable, 1024)
+static tDMAControlTable g_dmaControlTable[DMA_CHANNELS_USED];
+
+static bool g_dmaReady = false;
+
+// Enable the uDMA controller and install the channel control table
+void initDMA(void)
+{
+    if (g_dmaReady) {
+        return;
+    }
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    uDMAEnable();
+    uDMAControlBaseSet(g_dmaControlTable);
+
+    g_dmaReady = true;
+}
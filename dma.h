@@ -0,0 +1,14 @@
+/*
+ * dma.h
+ *
+ * Shared uDMA controller setup. Every module that uses a uDMA channel
+ * calls initDMA() first; it only does the work once.
+ */
+
+#ifndef DMA_H_
+#define DMA_H_
+
+// Enable the uDMA controller and install the channel control table
+void initDMA(void);
+
+#endif /* DMA_H_ */
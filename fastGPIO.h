@@ -0,0 +1,68 @@
+/*
+ * fastGPIO.h
+ *
+ * Direct register access for the GPIO pins read on hot paths (yaw
+ * encoder and reference ISRs, button polling). The driverlib calls
+ * GPIOPinRead()/GPIOIntClear() are real function calls with argument
+ * checks; these compile down to a single load or store when base and
+ * pins are constants.
+ *
+ * Only use these on pins already configured through driverlib.
+ *
+ * Defining FAST_GPIO_SIM routes the register accesses to fastGPIOSim.c
+ * instead, which models the data register address masking and the
+ * interrupt clear over an array of ports, for running on a PC.
+ */
+
+#ifndef FASTGPIO_H_
+#define FASTGPIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef FAST_GPIO_SIM
+
+#define GPIO_O_DATA             0x00000000
+#define GPIO_O_ICR              0x0000041C
+
+uint32_t fastGPIOSimRead(uint32_t ui32Addr);
+void fastGPIOSimWrite(uint32_t ui32Addr, uint32_t ui32Value);
+
+// Drive the pin levels of a port. Pins that change latch their
+// interrupt flag, as with GPIO_BOTH_EDGES.
+void fastGPIOSimSetPins(uint32_t ui32Port, uint8_t ui8Levels);
+
+// Pending pin interrupt flags of a port
+uint8_t fastGPIOSimPending(uint32_t ui32Port);
+
+#define FAST_GPIO_READ(addr)            fastGPIOSimRead(addr)
+#define FAST_GPIO_WRITE(addr, value)    fastGPIOSimWrite((addr), (value))
+
+#else
+
+#include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
+
+#define FAST_GPIO_READ(addr)            HWREG(addr)
+#define FAST_GPIO_WRITE(addr, value)    (HWREG(addr) = (value))
+
+#endif
+
+// Read the masked pins of a port. Bits outside pins read as 0, matching
+// GPIOPinRead(). The data register is address-masked: bits [9:2] of the
+// address select which pins take part in the access.
+static inline uint32_t
+fastGPIORead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return FAST_GPIO_READ(ui32Port + GPIO_O_DATA + ((uint32_t)ui8Pins << 2));
+}
+
+// Clear the pin interrupts of a port, matching GPIOIntClear() for pin
+// interrupt flags.
+static inline void
+fastGPIOIntClear(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    FAST_GPIO_WRITE(ui32Port + GPIO_O_ICR, ui8Pins);
+}
+
+#endif /* FASTGPIO_H_ */
@@ -0,0 +1,72 @@
+/*
+ * fastGPIOSim.c
+ *
+ * GPIO registers for a PC build of fastGPIO.h (define FAST_GPIO_SIM).
+ * Each port keeps its pin levels and pending interrupt flags in an
+ * array indexed by the port's 4 kB register block, so the real port
+ * base addresses work unchanged. Reads from the data register are
+ * masked by address bits [9:2] as on the part, and writes to the
+ * interrupt clear register clear the flags written as 1.
+ */
+
+#ifdef FAST_GPIO_SIM
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fastGPIO.h"
+
+// Enough 4 kB blocks to cover ports A-F on both buses
+#define FAST_GPIO_SIM_PORTS     64
+#define FAST_GPIO_SIM_BLOCK     0x1000
+#define FAST_GPIO_DATA_SPAN     0x400       // Masked data register aliases
+
+typedef struct {
+    uint8_t data;           // Pin levels
+    uint8_t ris;            // Latched interrupt flags
+} simPort_t;
+
+static simPort_t g_ports[FAST_GPIO_SIM_PORTS];
+
+static simPort_t *
+simPort(uint32_t ui32Addr)
+{
+    return &g_ports[(ui32Addr / FAST_GPIO_SIM_BLOCK) % FAST_GPIO_SIM_PORTS];
+}
+
+uint32_t
+fastGPIOSimRead(uint32_t ui32Addr)
+{
+    uint32_t offset = ui32Addr % FAST_GPIO_SIM_BLOCK;
+
+    if (offset < FAST_GPIO_DATA_SPAN) {
+        return simPort(ui32Addr)->data & (offset >> 2);
+    }
+
+    return 0;
+}
+
+void
+fastGPIOSimWrite(uint32_t ui32Addr, uint32_t ui32Value)
+{
+    if (ui32Addr % FAST_GPIO_SIM_BLOCK == GPIO_O_ICR) {
+        simPort(ui32Addr)->ris &= ~ui32Value;
+    }
+}
+
+void
+fastGPIOSimSetPins(uint32_t ui32Port, uint8_t ui8Levels)
+{
+    simPort_t *port = simPort(ui32Port);
+
+    port->ris |= port->data ^ ui8Levels;
+    port->data = ui8Levels;
+}
+
+uint8_t
+fastGPIOSimPending(uint32_t ui32Port)
+{
+    return simPort(ui32Port)->ris;
+}
+
+#endif /* FAST_GPIO_SIM */
@@ -0,0 +1,51 @@
+/*
+ * flashDev.c
+ *
+ * Flash log device for the target: drives the flash memory controller
+ * registers directly, so an erase or program can be started without
+ * waiting for it as the driverlib Flash calls do.
+ */
+
+#ifndef FLASH_SIM
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_flash.h"
+#include "inc/hw_types.h"
+
+#include "flashDev.h"
+
+void flashDevInit(void)
+{
+    // Nothing to set up -- the controller runs from the system clock
+}
+
+void flashDevErase(uint32_t addr)
+{
+    HWREG(FLASH_FCMISC) = FLASH_FCMISC_AMISC | FLASH_FCMISC_VOLTMISC |
+                          FLASH_FCMISC_ERMISC;
+    HWREG(FLASH_FMA) = FLASH_LOG_BASE + addr;
+    HWREG(FLASH_FMC) = FLASH_FMC_WRKEY | FLASH_FMC_ERASE;
+}
+
+void flashDevProgram(uint32_t addr, uint32_t word)
+{
+    HWREG(FLASH_FCMISC) = FLASH_FCMISC_AMISC | FLASH_FCMISC_VOLTMISC |
+                          FLASH_FCMISC_INVDMISC | FLASH_FCMISC_PROGMISC;
+    HWREG(FLASH_FMA) = FLASH_LOG_BASE + addr;
+    HWREG(FLASH_FMD) = word;
+    HWREG(FLASH_FMC) = FLASH_FMC_WRKEY | FLASH_FMC_WRITE;
+}
+
+bool flashDevBusy(void)
+{
+    return (HWREG(FLASH_FMC) & (FLASH_FMC_WRITE | FLASH_FMC_ERASE)) != 0;
+}
+
+const uint8_t *flashDevRead(uint32_t addr)
+{
+    return (const uint8_t *)(FLASH_LOG_BASE + addr);
+}
+
+#endif /* FLASH_SIM */
@@ -0,0 +1,48 @@
+/*
+ * flashDev.h
+ *
+ * Raw access to the internal flash reserved for the flight log. The
+ * target build drives the flash controller directly; defining
+ * FLASH_SIM instead builds flashDevSim.c, a file-backed copy with
+ * per-page erase counters, for running the log code on a PC.
+ *
+ * Erase and program only start the operation; poll flashDevBusy()
+ * before starting the next one. While the controller is busy, any
+ * fetch from flash stalls the CPU -- about 30 us for a word and up to
+ * 15 ms for a page erase.
+ */
+
+#ifndef FLASHDEV_H_
+#define FLASHDEV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Top 64 kB of flash. The linker command file keeps code out of it.
+#define FLASH_LOG_BASE          0x00030000
+#define FLASH_LOG_SIZE          0x00010000
+#define FLASH_PAGE_SIZE         1024        // Erase unit
+#define FLASH_LOG_PAGES         (FLASH_LOG_SIZE / FLASH_PAGE_SIZE)
+
+// Prepare the flash device. Call once before anything else.
+void flashDevInit(void);
+
+// Start erasing the page at byte offset addr into the log area
+void flashDevErase(uint32_t addr);
+
+// Start programming one word at byte offset addr into the log area.
+// Programming can only clear bits.
+void flashDevProgram(uint32_t addr, uint32_t word);
+
+// Return true while an erase or program is in progress
+bool flashDevBusy(void);
+
+// Return a pointer to byte offset addr into the log area
+const uint8_t *flashDevRead(uint32_t addr);
+
+#ifdef FLASH_SIM
+// Number of times a page has been erased
+uint32_t flashDevWear(uint16_t page);
+#endif
+
+#endif /* FLASHDEV_H_ */
@@ -0,0 +1,92 @@
+/*
+ * flashDevSim.c
+ *
+ * Flash log device for a PC build (define FLASH_SIM). The log area is
+ * kept in memory and mirrored to FLASH_SIM_FILE so it survives a
+ * restart, as flash would. Programming ANDs bits in like real NOR
+ * flash, and every page erase is counted for wear checks.
+ */
+
+#ifdef FLASH_SIM
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "flashDev.h"
+
+#ifndef FLASH_SIM_FILE
+#define FLASH_SIM_FILE          "flashlog.bin"
+#endif
+
+static uint8_t g_flash[FLASH_LOG_SIZE];
+static uint32_t g_wear[FLASH_LOG_PAGES];
+static FILE *g_file;
+
+// Write a range back to the file
+static void flush(uint32_t addr, uint32_t len)
+{
+    if (g_file) {
+        fseek(g_file, addr, SEEK_SET);
+        fwrite(&g_flash[addr], 1, len, g_file);
+        fflush(g_file);
+    }
+}
+
+void flashDevInit(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < FLASH_LOG_SIZE; i++) {
+        g_flash[i] = 0xFF;
+    }
+
+    g_file = fopen(FLASH_SIM_FILE, "r+b");
+    if (g_file) {
+        fread(g_flash, 1, FLASH_LOG_SIZE, g_file);
+    }
+    else {
+        g_file = fopen(FLASH_SIM_FILE, "w+b");
+        flush(0, FLASH_LOG_SIZE);
+    }
+}
+
+void flashDevErase(uint32_t addr)
+{
+    uint32_t i;
+
+    addr -= addr % FLASH_PAGE_SIZE;
+    for (i = 0; i < FLASH_PAGE_SIZE; i++) {
+        g_flash[addr + i] = 0xFF;
+    }
+    g_wear[addr / FLASH_PAGE_SIZE]++;
+    flush(addr, FLASH_PAGE_SIZE);
+}
+
+void flashDevProgram(uint32_t addr, uint32_t word)
+{
+    uint8_t i;
+
+    addr -= addr % 4;
+    for (i = 0; i < 4; i++) {
+        g_flash[addr + i] &= word >> (8 * i);
+    }
+    flush(addr, 4);
+}
+
+bool flashDevBusy(void)
+{
+    return false;
+}
+
+const uint8_t *flashDevRead(uint32_t addr)
+{
+    return &g_flash[addr];
+}
+
+uint32_t flashDevWear(uint16_t page)
+{
+    return page < FLASH_LOG_PAGES ? g_wear[page] : 0;
+}
+
+#endif /* FLASH_SIM */
@@ -0,0 +1,288 @@
+/*
+ * flashLog.c
+ *
+ * Circular flight log in internal flash. See flashLog.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "flashLog.h"
+#include "flashDev.h"
+#include "recorder.h"
+#include "telemetry.h"
+
+//**********************************************************************
+// Constants
+//**********************************************************************
+#define FLASH_SLOT_SIZE         RECORDER_BLOCK_SIZE
+#define FLASH_SLOT_WORDS        (FLASH_SLOT_SIZE / 4)
+#define FLASH_SLOTS             (FLASH_LOG_SIZE / FLASH_SLOT_SIZE)
+#define FLASH_SLOTS_PER_PAGE    (FLASH_PAGE_SIZE / FLASH_SLOT_SIZE)
+#define FLASH_QUEUE_LEN         2
+#define FLASH_ERASED            0xFFFFFFFF
+
+//**********************************************************************
+// Globals to module
+//**********************************************************************
+static uint8_t g_queue[FLASH_QUEUE_LEN][FLASH_SLOT_SIZE];
+static uint8_t g_queueHead;
+static uint8_t g_queueCount;
+static uint8_t g_word;                  // Next word of the head block, 0 = not started
+
+static uint16_t g_nextSlot;             // Slot the next block goes in
+static uint16_t g_freeSlots;            // Erased slots from g_nextSlot on
+static uint16_t g_erasePage;            // Next page to erase ahead
+static uint16_t g_clearPages;           // Pages left to erase for a clear
+static uint32_t g_sequence;             // For the next block written
+static uint32_t g_dropped;
+static bool g_idle = true;
+
+static bool g_dumping;
+static bool g_dumpInfoSent;
+static uint32_t g_dumpOffset;
+
+//**********************************************************************
+// Helpers
+//**********************************************************************
+static uint32_t readWord(uint32_t addr)
+{
+    const uint8_t *p = flashDevRead(addr);
+
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static bool slotErased(uint16_t slot)
+{
+    uint8_t i;
+
+    for (i = 0; i < FLASH_SLOT_WORDS; i++) {
+        if (readWord(slot * FLASH_SLOT_SIZE + i * 4) != FLASH_ERASED) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//**********************************************************************
+// Find the newest block, then the erased run after it. Every piece of
+// state is set here, so calling it again is the same as a reset.
+//**********************************************************************
+void initFlashLog(void)
+{
+    uint32_t sequence;
+    uint16_t slot;
+    bool found = false;
+
+    g_queueHead = 0;
+    g_queueCount = 0;
+    g_word = 0;
+    g_clearPages = 0;
+    g_dropped = 0;
+    g_idle = true;
+    g_dumping = false;
+
+    flashDevInit();
+
+    for (slot = 0; slot < FLASH_SLOTS; slot++) {
+        sequence = readWord(slot * FLASH_SLOT_SIZE);
+        if (sequence != FLASH_ERASED && (!found || sequence > g_sequence)) {
+            g_sequence = sequence;
+            g_nextSlot = slot;
+            found = true;
+        }
+    }
+
+    if (found) {
+        g_nextSlot = (g_nextSlot + 1) % FLASH_SLOTS;
+        g_sequence++;
+    }
+    else {
+        g_nextSlot = 0;
+        g_sequence = 1;
+    }
+
+    // The header is written last, so a reset part-way through a block
+    // leaves a slot with no header but a dirty body. Step over it.
+    if (readWord(g_nextSlot * FLASH_SLOT_SIZE) == FLASH_ERASED
+        && !slotErased(g_nextSlot)) {
+        g_nextSlot = (g_nextSlot + 1) % FLASH_SLOTS;
+    }
+
+    g_freeSlots = 0;
+    while (g_freeSlots < FLASH_SLOTS
+           && slotErased((g_nextSlot + g_freeSlots) % FLASH_SLOTS)) {
+        g_freeSlots++;
+    }
+
+    // Erases are whole pages, so the erased run must end on a page
+    // boundary to carry on from it. If it doesn't, give up the rest of
+    // the current page.
+    if ((g_nextSlot + g_freeSlots) % FLASH_SLOTS_PER_PAGE != 0) {
+        g_nextSlot = (g_nextSlot / FLASH_SLOTS_PER_PAGE + 1)
+                     * FLASH_SLOTS_PER_PAGE % FLASH_SLOTS;
+        g_freeSlots = 0;
+    }
+
+    g_erasePage = ((g_nextSlot + g_freeSlots) / FLASH_SLOTS_PER_PAGE)
+                  % FLASH_LOG_PAGES;
+}
+
+//**********************************************************************
+// Writing
+//**********************************************************************
+void flashLogAppend(const uint8_t *block)
+{
+    uint8_t *slot;
+    uint16_t i;
+
+    if (g_idle || g_clearPages > 0) {
+        return;
+    }
+
+    if (g_queueCount == FLASH_QUEUE_LEN) {
+        g_dropped++;
+        return;
+    }
+
+    slot = g_queue[(g_queueHead + g_queueCount) % FLASH_QUEUE_LEN];
+    for (i = 0; i < FLASH_SLOT_SIZE; i++) {
+        slot[i] = block[i];
+    }
+    g_queueCount++;
+}
+
+// Program the next word of the head block. Words 1 onwards go first
+// and the header last, so only complete blocks have a header.
+static void programNextWord(void)
+{
+    uint8_t *block = g_queue[g_queueHead];
+    uint8_t *p;
+    uint32_t word;
+    uint8_t index;
+
+    if (g_word == 0) {
+        if (g_freeSlots == 0) {
+            g_dropped++;
+            g_queueHead = (g_queueHead + 1) % FLASH_QUEUE_LEN;
+            g_queueCount--;
+            return;
+        }
+        putU32(block, g_sequence++);
+        g_word = 1;
+    }
+
+    index = (g_word < FLASH_SLOT_WORDS) ? g_word : 0;
+    p = block + index * 4;
+    word = p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+
+    if (word != FLASH_ERASED) {
+        flashDevProgram(g_nextSlot * FLASH_SLOT_SIZE + index * 4, word);
+    }
+
+    if (g_word++ == FLASH_SLOT_WORDS) {
+        g_nextSlot = (g_nextSlot + 1) % FLASH_SLOTS;
+        g_freeSlots--;
+        g_word = 0;
+        g_queueHead = (g_queueHead + 1) % FLASH_QUEUE_LEN;
+        g_queueCount--;
+    }
+}
+
+//**********************************************************************
+// Dumping
+//**********************************************************************
+void flashLogStartDump(void)
+{
+    g_dumping = true;
+    g_dumpInfoSent = false;
+    g_dumpOffset = 0;
+}
+
+static void dumpNext(void)
+{
+    uint8_t frame[5 + FLASH_LOG_DUMP_CHUNK + TELEMETRY_CRC_LEN];
+    const uint8_t *data;
+    uint8_t *p;
+    uint8_t i;
+
+    if (!g_dumpInfoSent) {
+        frame[0] = TELEMETRY_TYPE_LOG_INFO;
+        frame[1] = 0;
+        p = putU16(frame + 2, FLASH_SLOT_SIZE);
+        p = putU16(p, FLASH_SLOTS);
+        g_dumpInfoSent = telemetrySubmit(frame, p - frame, sizeof(frame));
+        return;
+    }
+
+    frame[0] = TELEMETRY_TYPE_LOG_DATA;
+    p = putU32(frame + 1, g_dumpOffset);
+    data = flashDevRead(g_dumpOffset);
+    for (i = 0; i < FLASH_LOG_DUMP_CHUNK && g_dumpOffset + i < FLASH_LOG_SIZE; i++) {
+        *p++ = data[i];
+    }
+
+    if (telemetrySubmit(frame, p - frame, sizeof(frame))) {
+        g_dumpOffset += i;
+        if (g_dumpOffset >= FLASH_LOG_SIZE) {
+            g_dumping = false;
+        }
+    }
+}
+
+//**********************************************************************
+// Background work
+//**********************************************************************
+void flashLogPoll(bool idle)
+{
+    g_idle = idle;
+
+    if (g_dumping) {
+        dumpNext();
+    }
+
+    if (flashDevBusy()) {
+        return;
+    }
+
+    // Clearing: erase every page, then start from the beginning
+    if (g_clearPages > 0) {
+        if (idle) {
+            flashDevErase((FLASH_LOG_PAGES - g_clearPages) * FLASH_PAGE_SIZE);
+            if (--g_clearPages == 0) {
+                g_nextSlot = 0;
+                g_freeSlots = FLASH_SLOTS;
+                g_erasePage = 0;
+            }
+        }
+        return;
+    }
+
+    if (g_queueCount > 0) {
+        programNextWord();
+        return;
+    }
+
+    // Keep pages erased ahead for the next flight
+    if (idle && g_freeSlots < FLASH_LOG_ERASE_AHEAD * FLASH_SLOTS_PER_PAGE) {
+        flashDevErase(g_erasePage * FLASH_PAGE_SIZE);
+        g_erasePage = (g_erasePage + 1) % FLASH_LOG_PAGES;
+        g_freeSlots += FLASH_SLOTS_PER_PAGE;
+    }
+}
+
+void flashLogClear(void)
+{
+    g_queueCount = 0;
+    g_word = 0;
+    g_freeSlots = 0;
+    g_clearPages = FLASH_LOG_PAGES;
+}
+
+uint32_t flashLogDropped(void)
+{
+    return g_dropped;
+}
@@ -0,0 +1,56 @@
+/*
+ * flashLog.h
+ *
+ * Flight log in internal flash, so a record of the flight survives a
+ * reset or power cycle. Finished flight recorder blocks (recorder.h)
+ * are appended in order to a circular log of RECORDER_BLOCK_SIZE
+ * slots. The last, part-filled block is appended when the recorder
+ * freezes. A slot is the recorder block with its sequence number
+ * replaced by the log's own, which keeps counting across resets.
+ *
+ * Flash can only be erased a page at a time, and an erase stalls the
+ * CPU for milliseconds. So erases only run while the motors are off.
+ * Each idle period keeps FLASH_LOG_ERASE_AHEAD pages ready, overwriting
+ * the oldest flights. Programming runs one word per main loop pass.
+ * Blocks are only logged while the motors are on.
+ *
+ * A dump is a TELEMETRY_TYPE_LOG_INFO frame followed by
+ * TELEMETRY_TYPE_LOG_DATA frames covering the whole log area:
+ *   LOG_INFO:  uint8 type, uint8 0, uint16 slot size, uint16 slot
+ *              count, uint16 CRC
+ *   LOG_DATA:  uint8 type, uint32 byte offset, FLASH_LOG_DUMP_CHUNK
+ *              bytes, uint16 CRC
+ * tools/blackbox_decode.py decodes it like a recorder dump.
+ */
+
+#ifndef FLASHLOG_H_
+#define FLASHLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FLASH_LOG_ERASE_AHEAD   48      // Pages, about 45 s of flight
+#define FLASH_LOG_DUMP_CHUNK    48      // Fits a UART DMA buffer once encoded
+
+// Find the end of the log. Call once at start-up.
+void initFlashLog(void);
+
+// Queue a RECORDER_BLOCK_SIZE block for writing. Dropped if the motors
+// are off, the queue is full or the log has no erased slot left.
+void flashLogAppend(const uint8_t *block);
+
+// Advance any erase, program or dump in progress. Call every main loop
+// pass; idle is true while the motors are off. Never waits on the
+// flash.
+void flashLogPoll(bool idle);
+
+// Erase the whole log, in idle time
+void flashLogClear(void);
+
+// Start dumping the log over the UART
+void flashLogStartDump(void);
+
+// Number of blocks dropped for want of space
+uint32_t flashLogDropped(void);
+
+#endif /* FLASHLOG_H_ */
@@ -0,0 +1,68 @@
+/*
+ * intPriority.h
+ *
+ * Interrupt priority map for the whole firmware, plus BASEPRI-based
+ * critical sections. The TM4C123 implements the top three priority
+ * bits, so priorities step in units of 0x20; lower values preempt
+ * higher ones.
+ *
+ * Priority 0 is kept for the motor kill: BASEPRI cannot mask it, so
+ * nothing placed there can ever be held off by a critical section.
+ *
+ * Stack budget: the levels below nest four deep on top of main. With
+ * the FPU on, each exception frame reserves 104 bytes (26 words, lazy
+ * FP stacking), so the frames alone take 416 bytes before any handler
+ * or main() uses a byte. The stack is 2 kB (tm4c123gh6pm.cmd and
+ * --stack_size); the STACK command reports the deepest use seen since
+ * reset (stackUsage.h). Recheck it after adding a level or a handler
+ * with large locals.
+ */
+
+#ifndef INTPRIORITY_H_
+#define INTPRIORITY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "driverlib/interrupt.h"
+
+// Motor kill (PWM fault). Nothing may delay this.
+#define INT_PRIORITY_MOTOR_KILL 0x00
+
+// Encoder edges. The quadrature and reference ISRs share a level so
+// neither can preempt the other half-way through updating the count.
+#define INT_PRIORITY_YAW        0x20
+#define INT_PRIORITY_YAW_REF    0x20
+
+// Altitude sampling and the control timer
+#define INT_PRIORITY_ADC        0x40
+#define INT_PRIORITY_SYSTICK    0x40
+
+// User interface
+#define INT_PRIORITY_RESET      0xE0
+#define INT_PRIORITY_UART       0xE0
+#define INT_PRIORITY_DISPLAY    0xE0
+
+// Mask every interrupt at priority level and below (numerically >=),
+// leaving more urgent interrupts running. Returns the previous mask for
+// criticalExit(). Never lowers an existing mask, so sections nest.
+static inline uint32_t
+criticalEnter(uint32_t level)
+{
+    uint32_t previous = IntPriorityMaskGet();
+
+    if (previous == 0 || level < previous) {
+        IntPriorityMaskSet(level);
+    }
+
+    return previous;
+}
+
+// Restore the mask returned by the matching criticalEnter()
+static inline void
+criticalExit(uint32_t previous)
+{
+    IntPriorityMaskSet(previous);
+}
+
+#endif /* INTPRIORITY_H_ */
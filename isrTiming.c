@@ -0,0 +1,93 @@
+/*
+ * isrTiming.c
+ *
+ * ISR timing instrumentation using the Cortex-M4 DWT cycle counter.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_types.h"
+#include "inc/hw_nvic.h"
+
+#include "isrTiming.h"
+
+volatile uint32_t g_isrMaxRunCycles[NUM_ISRS];
+static volatile uint32_t g_sysTickMaxLatency;
+
+static uint32_t g_loopLast;             // Cycle count at the previous mark
+static uint32_t g_loopCycles;           // Latest loop period
+static uint32_t g_loopMaxCycles;        // Longest loop period
+
+// Enable the cycle counter and clear the recorded maxima
+void initISRTiming(void)
+{
+    uint8_t i;
+
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+
+    for (i = 0; i < NUM_ISRS; i++) {
+        g_isrMaxRunCycles[i] = 0;
+    }
+    g_sysTickMaxLatency = 0;
+    g_loopLast = 0;
+    g_loopCycles = 0;
+    g_loopMaxCycles = 0;
+}
+
+// Record SysTick's entry latency. The counter reloads to the period and
+// counts down, so the cycles since it fired are period - current.
+void isrTimingSysTickEntry(void)
+{
+    uint32_t latency = HWREG(NVIC_ST_RELOAD) - HWREG(NVIC_ST_CURRENT);
+
+    if (latency > g_sysTickMaxLatency) {
+        g_sysTickMaxLatency = latency;
+    }
+}
+
+// Longest run time of handler id in CPU cycles
+uint32_t getISRMaxRunCycles(uint8_t id)
+{
+    if (id >= NUM_ISRS) {
+        return 0;
+    }
+
+    return g_isrMaxRunCycles[id];
+}
+
+// Longest delay between SysTick firing and its handler starting
+uint32_t getSysTickMaxLatency(void)
+{
+    return g_sysTickMaxLatency;
+}
+
+// Record the cycles since the previous call. The first call only sets
+// the reference point.
+void loopTimingMark(void)
+{
+    uint32_t now = HWREG(DWT_CYCCNT);
+
+    if (g_loopLast != 0) {
+        g_loopCycles = now - g_loopLast;
+        if (g_loopCycles > g_loopMaxCycles) {
+            g_loopMaxCycles = g_loopCycles;
+        }
+    }
+
+    g_loopLast = now;
+}
+
+// Latest main loop period in CPU cycles
+uint32_t getLoopCycles(void)
+{
+    return g_loopCycles;
+}
+
+// Longest main loop period in CPU cycles
+uint32_t getLoopMaxCycles(void)
+{
+    return g_loopMaxCycles;
+}
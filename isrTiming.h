@@ -0,0 +1,73 @@
+/*
+ * isrTiming.h
+ *
+ * ISR timing instrumentation using the Cortex-M4 DWT cycle counter.
+ *
+ * Each instrumented handler records its longest run time (entry to
+ * exit) in CPU cycles. That is not its latency. Only SysTick records
+ * entry latency, because only its counter shows when it fired; an
+ * encoder edge or ADC completion leaves no timestamp to measure from.
+ * An upper bound on another ISR's latency can be worked out from the
+ * run times: the longest run of any one handler at its own level or
+ * below, plus the runs of the handlers above it.
+ */
+
+#ifndef ISRTIMING_H_
+#define ISRTIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_types.h"
+
+enum isrIds {ISR_SYSTICK = 0, ISR_ADC, ISR_YAW, ISR_YAW_REF, NUM_ISRS};
+
+// Debug registers used for cycle counting
+#define DEMCR                   0xE000EDFC
+#define DEMCR_TRCENA            0x01000000
+#define DWT_CTRL                0xE0001000
+#define DWT_CTRL_CYCCNTENA      0x00000001
+#define DWT_CYCCNT              0xE0001004
+
+extern volatile uint32_t g_isrMaxRunCycles[NUM_ISRS];
+
+// Enable the cycle counter and clear the recorded maxima
+void initISRTiming(void);
+
+// Cycle count at handler entry
+static inline uint32_t
+isrTimingStart(void)
+{
+    return HWREG(DWT_CYCCNT);
+}
+
+// Record the run time of handler id, given its entry cycle count
+static inline void
+isrTimingEnd(uint8_t id, uint32_t start)
+{
+    uint32_t cycles = HWREG(DWT_CYCCNT) - start;
+
+    if (cycles > g_isrMaxRunCycles[id]) {
+        g_isrMaxRunCycles[id] = cycles;
+    }
+}
+
+// Record SysTick's entry latency, call first thing in its handler
+void isrTimingSysTickEntry(void);
+
+// Longest run time of handler id in CPU cycles (not its latency)
+uint32_t getISRMaxRunCycles(uint8_t id);
+
+// Longest delay between SysTick firing and its handler starting
+uint32_t getSysTickMaxLatency(void);
+
+// Main loop period: call once per pass to record the cycles since the
+// previous call
+void loopTimingMark(void);
+
+// Latest and longest main loop period in CPU cycles
+uint32_t getLoopCycles(void);
+
+uint32_t getLoopMaxCycles(void);
+
+#endif /* ISRTIMING_H_ */
@@ -34,6 +34,15 @@
 #include "yawDetection.h"
 #include "reset.h"
 #include "altADC.h"
+#include "orient.h"
+#include "intPriority.h"
+#include "isrTiming.h"
+#include "stackUsage.h"
+#include "pwmBench.h"
+#include "telemetry.h"
+#include "command.h"
+#include "recorder.h"
+#include "flashLog.h"
 
 //*****************************************************************************
 // Constants
@@ -41,15 +50,20 @@
 #define BUF_SIZE            20
 #define SYSTICK_RATE_HZ     100
 #define SLOWTICK_RATE_HZ    4
+#define PERMILLE_PER_PCT    10
+
+// Define to run the PWM frequency sweep benchmark once on each take-off
+//#define PWM_BENCH
 
 // Enumerations
-enum modeNum {LANDED = 0, ORIENTING, FLYING, LANDING};
+enum modeNum {LANDED = 0, ORIENTING, FLYING, LANDING, SAFE};
 
 //*****************************************************************************
 // Global variables
 //*****************************************************************************
 static uint32_t g_ulSampCnt;            // Counter for the interrupts
 volatile uint8_t slowTick = false;
+volatile uint8_t telemetryTick = false;
 
 //*****************************************************************************
 //
@@ -58,12 +72,19 @@ volatile uint8_t slowTick = false;
 //*****************************************************************************
 void SysTickIntHandler(void)
 {
+    uint32_t start = isrTimingStart();
+
+    isrTimingSysTickEntry();
+
     //
     // Initiate a conversion
     //
     triggerADC();
     g_ulSampCnt++;
 
+    // Slew the motor outputs towards the latest command
+    updateRotorSlew();
+
     static uint8_t tickCount = 0;
     const uint8_t ticksPerSlow = SYSTICK_RATE_HZ / SLOWTICK_RATE_HZ;
 
@@ -72,6 +93,47 @@ void SysTickIntHandler(void)
         tickCount = 0;
         slowTick = true;
     }
+
+    static uint8_t telemetryCount = 0;
+
+    if(++telemetryCount >= getTelemetryDivider())
+    {
+        telemetryCount = 0;
+        telemetryTick = true;
+    }
+
+    isrTimingEnd(ISR_SYSTICK, start);
+}
+
+//*****************************************************************************
+// Publish the telemetry channels for this control tick
+//*****************************************************************************
+static void publishTelemetry(int16_t altitude, int16_t desired_alt,
+    int16_t yaw, int16_t desired_yaw, uint16_t main_duty, uint16_t tail_duty,
+    uint8_t mode)
+{
+    float P, I, D;
+
+    telemetryPublish(TCH_ALT, altitude);
+    telemetryPublish(TCH_DESIRED_ALT, desired_alt);
+    telemetryPublish(TCH_YAW, yaw);
+    telemetryPublish(TCH_DESIRED_YAW, desired_yaw);
+    telemetryPublish(TCH_MAIN_DUTY, main_duty);
+    telemetryPublish(TCH_TAIL_DUTY, tail_duty);
+    telemetryPublish(TCH_MODE, mode);
+
+    // PID terms in hundredths of a percent
+    getAltTerms(&P, &I, &D);
+    telemetryPublish(TCH_ALT_P, P * 100);
+    telemetryPublish(TCH_ALT_I, I * 100);
+    telemetryPublish(TCH_ALT_D, D * 100);
+
+    getYawTerms(&P, &I, &D);
+    telemetryPublish(TCH_YAW_P, P * 100);
+    telemetryPublish(TCH_YAW_I, I * 100);
+    telemetryPublish(TCH_YAW_D, D * 100);
+
+    telemetryPublish(TCH_LOOP_CYCLES, getLoopCycles());
 }
 
 //*****************************************************************************
@@ -89,6 +151,7 @@ void initClock(void)
     //
     // Register the interrupt handler
     SysTickIntRegister(SysTickIntHandler);
+    IntPrioritySet(FAULT_SYSTICK, INT_PRIORITY_SYSTICK);
     //
     // Enable interrupt and device
     SysTickIntEnable();
@@ -96,7 +159,7 @@ void initClock(void)
 }
 
 void main(void) {
-    char mode_names[4][10] = {"landed", "orienting", "flying", "landing"};
+    char mode_names[5][10] = {"landed", "orienting", "flying", "landing", "safe"};
 
     int32_t actual_yaw;              // Raw, unconverted yaw value
     int32_t desired_yaw = 0;
@@ -104,15 +167,22 @@ void main(void) {
     int16_t actual_alt;
     int16_t desired_alt = 0;
 
-    uint16_t main_duty = 0;
-    uint16_t tail_duty = 0;
+    // Rotor duties in permille; reported in percent
+    uint16_t main_permille = 0;
+    uint16_t tail_permille = 0;
+    uint16_t main_duty, tail_duty;
 
     uint8_t switchCurState = 0, switchPrevState = 0;
     uint8_t programStart = 1;
     uint8_t mode = LANDED;
-    uint8_t yawRef = 1;
+    uint8_t orientStatus;
+    bool benchRunning = false;
+    int32_t cmdValue;
+    bool cmdFly, cmdLand;
 
     // Initialize each of the modules
+    initStackUsage();
+    initISRTiming();
     initClock();
     initADC();
     initButtons();  // Initialises 4 pushbuttons (UP, DOWN, LEFT, RIGHT)
@@ -123,23 +193,47 @@ void main(void) {
     initRef();
     initialiseMainPWM();
     initialiseTailPWM();
+    startRotorPWM();
+    initMotorKill();
+    initRecorder();
+    initFlashLog();
 
     // Enable interrupts to the processor.
     IntMasterEnable();
 
     while(1) {
 
+        kickMotorWatchdog();
+        loopTimingMark();
+        commandPoll(g_ulSampCnt);
+        recorderPoll();
+        flashLogPoll(mode == LANDED || mode == SAFE);
         updateAlt();
 
+        // Motors cut by the kill input or watchdog -- stay down until reset
+        if (isMotorKilled()) {
+            mode = SAFE;
+            recorderFreeze(REC_CAUSE_KILL);
+        }
+
         // Get the current state of the SW1 switch
         switchCurState = checkSwitch();
 
+        // MODE commands from the UART stand in for the switch
+        cmdFly = false;
+        cmdLand = false;
+        if (checkCommand(CMD_MODE, &cmdValue)) {
+            cmdFly = (cmdValue == CMD_MODE_FLY);
+            cmdLand = (cmdValue == CMD_MODE_LAND);
+        }
+
         // Heli State Machine
         switch(mode) {
             case LANDED:
 
                 // Initial state -- heli needs to orient
-                if(switchCurState && (switchCurState != switchPrevState) && programStart)
+                if(((switchCurState && (switchCurState != switchPrevState)) || cmdFly)
+                    && programStart)
                 {
                     mode = ORIENTING;
                     switchPrevState = switchCurState;
@@ -148,37 +242,55 @@ void main(void) {
                     // Turn on motor output
                     setMainPWMOutput(true);
                     setTailPWMOutput(true);
+
+                    startOrient(g_ulSampCnt);
                 }
 
                 // Heli already oriented, switch state to FLYING
-                else if(switchCurState && (switchCurState != switchPrevState))
+                else if((switchCurState && (switchCurState != switchPrevState)) || cmdFly)
                 {
                     mode = FLYING;
                     switchPrevState = switchCurState;
                 }
 
+                // Track the switch going down so it can be raised again
+                else if (!switchCurState)
+                {
+                    switchPrevState = switchCurState;
+                }
+
                 break;
 
 
             case ORIENTING:
 
-                // Check if we've reached the reference signal
-                yawRef = checkYawRef();
+                // Sweep for the reference signal
+                orientStatus = updateOrient(g_ulSampCnt, &main_permille, &tail_permille);
 
-                if (!yawRef) {
+                if (orientStatus == ORIENT_DONE) {
                     desired_alt = 0;
                     desired_yaw = 0;
                     actual_yaw = 0;
-
-                    main_duty = 0;
-                    tail_duty = 0;
                     mode = FLYING;
+
+#ifdef PWM_BENCH
+                    startPWMBench(g_ulSampCnt);
+                    benchRunning = true;
+#endif
                 }
 
-                else {
-                    // Set main and tail duty to find ref yaw
-                    main_duty = 5;
-                    tail_duty = 10;
+                // Never found the reference -- shut down and let the
+                // switch be cycled to try again. Keep the recording of
+                // the search and say why the heli landed.
+                else if (orientStatus == ORIENT_TIMEOUT) {
+                    setMainPWMOutput(false);
+                    setTailPWMOutput(false);
+                    recorderFreeze(REC_CAUSE_ORIENT);
+                    if(getTelemetryMode() == TELEMETRY_TEXT) {
+                        UARTSend("Orient timeout: no yaw reference\n\r");
+                    }
+                    programStart = 1;
+                    mode = LANDED;
                 }
 
                 break;
@@ -186,10 +298,20 @@ void main(void) {
             case FLYING:
 
                 // switch down = go to landing
-                if(!switchCurState && (switchCurState != switchPrevState))
+                if((!switchCurState && (switchCurState != switchPrevState)) || cmdLand)
                 {
                     mode = LANDING;
                     switchPrevState = switchCurState;
+
+                    // Abandon a sweep part-way and go back to the default
+                    if (benchRunning) {
+                        setPWMProfile(PWM_PROFILE_200HZ);
+                        benchRunning = false;
+                    }
+                }
+
+                if (benchRunning) {
+                    benchRunning = updatePWMBench(g_ulSampCnt);
                 }
 
                 // *******************************************
@@ -209,12 +331,23 @@ void main(void) {
 
                 // Rotate 15 degrees ccw
                 if(checkButton(LEFT) == PUSHED && mode == FLYING) {
-                    desired_yaw += 15;
+                    desired_yaw = wrapYaw(desired_yaw + 15);
                 }
 
                 // Rotate 15 degrees cw
                 if(checkButton(RIGHT) == PUSHED && mode == FLYING) {
-                    desired_yaw -= 15;
+                    desired_yaw = wrapYaw(desired_yaw - 15);
+                }
+
+                // *******************************************
+                // *** UART CONTROL ***
+                // *******************************************
+                if(checkCommand(CMD_ALT, &cmdValue) && mode == FLYING) {
+                    desired_alt = cmdValue;
+                }
+
+                if(checkCommand(CMD_YAW, &cmdValue) && mode == FLYING) {
+                    desired_yaw = cmdValue;
                 }
 
                 break;
@@ -238,29 +371,62 @@ void main(void) {
                     setTailPWMOutput(false);
                 }
 
+                break;
+
+            case SAFE:
+
+                desired_alt = 0;
+                desired_yaw = 0;
+                main_permille = 0;
+                tail_permille = 0;
+
                 break;
         }
 
+        // ALT and YAW are refused, and any queued dropped, unless flying
+        setCommandFlying(mode == FLYING);
+
         // Get actual yaw and altitude measurements
         actual_yaw = getYaw();
         actual_alt = getAlt();
 
         // Pulse Width Sets
-        // Set main motor
-        setMainPWM(main_duty);
-
-        // Set tail motor
-        setTailPWM(tail_duty);
+        // Set main and tail motors together
+        setRotorPermille(main_permille, tail_permille);
 
         // PID control
-        main_duty = alt_pid(actual_alt, desired_alt, .005);
-        tail_duty = yaw_pid(actual_yaw, desired_yaw, .005);
+        main_permille = alt_pid(actual_alt, desired_alt, .005, isMainSlewLimited());
+        tail_permille = yaw_pid(actual_yaw, desired_yaw, .005, isTailSlewLimited());
+        main_duty = main_permille / PERMILLE_PER_PCT;
+        tail_duty = tail_permille / PERMILLE_PER_PCT;
+
+        recorderLog(g_ulSampCnt, main_duty, tail_duty, actual_alt, desired_alt,
+            actual_yaw, desired_yaw, mode, getLoopCycles());
+
+        // Binary telemetry runs faster than the text output
+        if(telemetryTick) {
+            telemetryTick = false;
+
+            if(getTelemetryMode() == TELEMETRY_BINARY) {
+                sendTelemetryFrame(g_ulSampCnt, main_duty, tail_duty,
+                    actual_alt, desired_alt, actual_yaw, desired_yaw, mode);
+            }
+            else if(getTelemetryMode() == TELEMETRY_CHANNELS) {
+                publishTelemetry(actual_alt, desired_alt, actual_yaw,
+                    desired_yaw, main_duty, tail_duty, mode);
+                sendTelemetryChannels(g_ulSampCnt);
+            }
+        }
 
         // Set a delay on display/UART output
         if(slowTick) {
+            slowTick = false;
+
             // Send UART output
-            formatUARTOutput(main_duty, tail_duty, actual_alt, desired_alt,
-                actual_yaw, desired_yaw, mode_names[mode]);
+            if(getTelemetryMode() == TELEMETRY_TEXT) {
+                formatUARTOutput(main_duty, tail_duty, actual_alt, desired_alt,
+                    actual_yaw, desired_yaw, mode_names[mode]);
+            }
 
             // Display flight data on OLED (alt, yaw, main dc, tail dc, yaw)
             displayFlightData(actual_alt, main_duty, tail_duty, actual_yaw);
@@ -0,0 +1,114 @@
+/*
+ * numFormat.c
+ *
+ * Small number formatting without printf. See numFormat.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "numFormat.h"
+
+// Write the digits of value, most significant first, with at least
+// min_digits digits and an optional sign, right-aligned in width
+static char *
+emit(char *dst, uint32_t value, bool negative, uint8_t min_digits,
+     uint8_t width)
+{
+    char digits[FMT_UINT_MAX_LEN];
+    uint8_t count = 0;
+    uint8_t len;
+
+    // Digits come out least significant first
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0 || count < min_digits);
+
+    len = count + (negative ? 1 : 0);
+    while (width > len) {
+        *dst++ = ' ';
+        width--;
+    }
+
+    if (negative) {
+        *dst++ = '-';
+    }
+    while (count > 0) {
+        *dst++ = digits[--count];
+    }
+
+    *dst = '\0';
+    return dst;
+}
+
+// Magnitude of a signed value, safe for INT32_MIN
+static uint32_t
+magnitude(int32_t value)
+{
+    return value < 0 ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+}
+
+char *fmtStr(char *dst, const char *src)
+{
+    while (*src != '\0') {
+        *dst++ = *src++;
+    }
+
+    *dst = '\0';
+    return dst;
+}
+
+char *fmtUint(char *dst, uint32_t value, uint8_t width)
+{
+    return emit(dst, value, false, 1, width);
+}
+
+char *fmtInt(char *dst, int32_t value, uint8_t width)
+{
+    return emit(dst, magnitude(value), value < 0, 1, width);
+}
+
+char *fmtFixed(char *dst, int32_t value, uint8_t places, uint8_t width)
+{
+    uint32_t scale = 1;
+    uint32_t mag = magnitude(value);
+    uint8_t i;
+    char *start = dst;
+    char *end;
+    uint8_t len;
+
+    if (places == 0) {
+        return fmtInt(dst, value, width);
+    }
+
+    if (places > FMT_FIXED_MAX_PLACES) {
+        places = FMT_FIXED_MAX_PLACES;
+    }
+
+    for (i = 0; i < places; i++) {
+        scale *= 10;
+    }
+
+    // Whole part with the sign, then the fraction with leading zeros
+    dst = emit(dst, mag / scale, value < 0, 1, 0);
+    *dst++ = '.';
+    end = emit(dst, mag % scale, false, places, 0);
+
+    // Shift right into the field if it is short, the NUL and last
+    // character first
+    len = (uint8_t)(end - start);
+    if (len < width) {
+        uint8_t pad = width - len;
+
+        for (i = len + 1; i-- > 0; ) {
+            start[i + pad] = start[i];
+        }
+        for (i = 0; i < pad; i++) {
+            start[i] = ' ';
+        }
+        end += pad;
+    }
+
+    return end;
+}
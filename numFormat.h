@@ -0,0 +1,44 @@
+/*
+ * numFormat.h
+ *
+ * Small number formatting for the UART and OLED output. Each emitter
+ * writes straight into the caller's buffer, NUL-terminates it and
+ * returns a pointer to the terminator, so calls chain:
+ *
+ *     p = fmtStr(str, "Alt: ");
+ *     p = fmtInt(p, altitude, 0);
+ *
+ * There are no format strings to parse and no state, so the functions
+ * are safe from any context. Widths pad on the left with spaces; a
+ * value wider than the field is written in full.
+ */
+
+#ifndef NUMFORMAT_H_
+#define NUMFORMAT_H_
+
+#include <stdint.h>
+
+// Longest output of each emitter, excluding width padding and the NUL
+#define FMT_UINT_MAX_LEN    10      // 4294967295
+#define FMT_INT_MAX_LEN     11      // -2147483648
+#define FMT_FIXED_MAX_LEN   12      // -214748.3648, -2.147483648
+
+// Most decimal places fmtFixed() takes. 10^9 is the largest power of
+// ten a uint32_t holds, and nine fraction digits fit FMT_UINT_MAX_LEN.
+#define FMT_FIXED_MAX_PLACES 9
+
+// Copy a string
+char *fmtStr(char *dst, const char *src);
+
+// Unsigned decimal, right-aligned in width characters
+char *fmtUint(char *dst, uint32_t value, uint8_t width);
+
+// Signed decimal, right-aligned in width characters
+char *fmtInt(char *dst, int32_t value, uint8_t width);
+
+// Fixed-point decimal: value is in units of 10^-places, so
+// fmtFixed(p, 1234, 2, 0) writes "12.34". Right-aligned in width.
+// places above FMT_FIXED_MAX_PLACES is taken as FMT_FIXED_MAX_PLACES.
+char *fmtFixed(char *dst, int32_t value, uint8_t places, uint8_t width);
+
+#endif /* NUMFORMAT_H_ */
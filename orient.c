@@ -0,0 +1,100 @@
+/*
+ * orient.c
+ *
+ * Reference search run in the ORIENTING state. The tail duty ramps up to
+ * the search duty so the heli doesn't lurch, then the heli sweeps one way
+ * for ORIENT_SWEEP_DEG before reversing and sweeping twice that the other
+ * way, so every reversal covers the full arc either side of the start.
+ * The search finishes as soon as the reference ISR has latched the index
+ * and aborts after ORIENT_TIMEOUT_TICKS.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "orient.h"
+#include "yawDetection.h"
+
+/**********************************************************
+ * Constants
+ **********************************************************/
+// Duties in permille
+#define ORIENT_MAIN_DUTY        50      // Just enough lift to turn freely
+#define ORIENT_TAIL_FWD_DUTY    100     // Tail duty for the first sweep
+#define ORIENT_TAIL_REV_DUTY    20      // Tail duty for the return sweep
+#define ORIENT_RAMP_STEP        10      // Tail duty change per SysTick
+#define ORIENT_SWEEP_DEG        200     // Sweep before the first reversal
+#define ORIENT_TIMEOUT_TICKS    1500    // 15 s at the 100 Hz SysTick
+
+#define ORIENT_SWEEP_COUNTS     (ORIENT_SWEEP_DEG * YAW_COUNTS_PER_REV / 360)
+
+/**********************************************************
+ * Globals to module
+ **********************************************************/
+static uint32_t start_tick;         // SysTick count the search began at
+static uint32_t last_tick;          // SysTick count of the last ramp step
+static int32_t leg_start;           // Encoder count the current sweep began at
+static int32_t leg_limit;           // Counts to travel before reversing
+static uint16_t tail_target;        // Duty the tail is ramping towards
+static uint16_t tail_current;       // Duty the tail is driven at now
+
+// Start a new search
+void startOrient(uint32_t ticks)
+{
+    start_tick = ticks;
+    last_tick = ticks;
+    leg_start = getYawCounts();
+    leg_limit = ORIENT_SWEEP_COUNTS;
+    tail_target = ORIENT_TAIL_FWD_DUTY;
+    tail_current = 0;
+}
+
+// Advance the search and set the duties for this pass
+uint8_t updateOrient(uint32_t ticks, uint16_t *main_duty, uint16_t *tail_duty)
+{
+    int32_t travelled;
+
+    // Reference latched by the ISR -- done
+    if (!checkYawRef()) {
+        *main_duty = 0;
+        *tail_duty = 0;
+        return ORIENT_DONE;
+    }
+
+    if (ticks - start_tick >= ORIENT_TIMEOUT_TICKS) {
+        *main_duty = 0;
+        *tail_duty = 0;
+        return ORIENT_TIMEOUT;
+    }
+
+    // Reverse once this sweep has covered its arc. Later sweeps go twice
+    // as far so they pass back over the start and out the other side.
+    travelled = getYawCounts() - leg_start;
+    if (travelled < 0) {
+        travelled = -travelled;
+    }
+    if (travelled >= leg_limit) {
+        leg_start = getYawCounts();
+        leg_limit = 2 * ORIENT_SWEEP_COUNTS;
+        tail_target = (tail_target == ORIENT_TAIL_FWD_DUTY) ?
+            ORIENT_TAIL_REV_DUTY : ORIENT_TAIL_FWD_DUTY;
+    }
+
+    // Ramp the tail towards the target one step per SysTick
+    while (last_tick != ticks) {
+        last_tick++;
+        if (tail_current + ORIENT_RAMP_STEP <= tail_target) {
+            tail_current += ORIENT_RAMP_STEP;
+        }
+        else if (tail_current >= tail_target + ORIENT_RAMP_STEP) {
+            tail_current -= ORIENT_RAMP_STEP;
+        }
+        else {
+            tail_current = tail_target;
+        }
+    }
+
+    *main_duty = ORIENT_MAIN_DUTY;
+    *tail_duty = tail_current;
+    return ORIENT_SEARCHING;
+}
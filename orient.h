@@ -0,0 +1,24 @@
+/*
+ * orient.h
+ *
+ * Reference search run in the ORIENTING state: ramps the tail up to a
+ * search duty, sweeps back and forth until the yaw reference is seen,
+ * and gives up after a timeout.
+ */
+
+#ifndef ORIENT_H_
+#define ORIENT_H_
+
+#include <stdint.h>
+
+enum orientStatus {ORIENT_SEARCHING = 0, ORIENT_DONE, ORIENT_TIMEOUT};
+
+// Start a new search. ticks is the current SysTick count.
+void startOrient(uint32_t ticks);
+
+// Advance the search. Writes the duties to drive this pass, in
+// permille, and returns the search status. ticks is the current
+// SysTick count.
+uint8_t updateOrient(uint32_t ticks, uint16_t *main_duty, uint16_t *tail_duty);
+
+#endif /* ORIENT_H_ */
@@ -0,0 +1,105 @@
+/*
+ * pwmBench.c
+ *
+ * PWM frequency sweep benchmark. For each profile: switch to it, let
+ * the heli settle, then average the altitude sample variance over the
+ * measurement window and log it over UART in text telemetry mode.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pwmBench.h"
+#include "pwmControl.h"
+#include "altADC.h"
+#include "uart.h"
+#include "numFormat.h"
+#include "telemetry.h"
+
+/**********************************************************
+ * Constants
+ **********************************************************/
+#define BENCH_SETTLE_TICKS      200     // 2 s at the 100 Hz SysTick
+#define BENCH_MEASURE_TICKS     300     // 3 s at the 100 Hz SysTick
+#define BENCH_RESTORE_PROFILE   PWM_PROFILE_200HZ
+
+enum benchPhases {BENCH_IDLE = 0, BENCH_SETTLING, BENCH_MEASURING};
+
+/**********************************************************
+ * Globals to module
+ **********************************************************/
+static uint8_t phase = BENCH_IDLE;
+static uint8_t profile;             // Profile being measured
+static uint32_t phase_tick;         // SysTick count the phase began at
+static uint32_t last_tick;          // SysTick count of the last sample
+static uint32_t variance_sum;       // Sum of variance samples this profile
+static uint32_t variance_count;     // Number of variance samples
+
+// Switch to a profile and start its settling time
+static void
+beginProfile(uint32_t ticks)
+{
+    setPWMProfile(profile);
+    phase = BENCH_SETTLING;
+    phase_tick = ticks;
+}
+
+// Start a sweep from the first profile
+void startPWMBench(uint32_t ticks)
+{
+    profile = 0;
+    beginProfile(ticks);
+}
+
+// Advance the sweep
+bool updatePWMBench(uint32_t ticks)
+{
+    char statusStr[40];
+    char *p;
+
+    switch (phase) {
+        case BENCH_SETTLING:
+            if (ticks - phase_tick >= BENCH_SETTLE_TICKS) {
+                phase = BENCH_MEASURING;
+                phase_tick = ticks;
+                last_tick = ticks;
+                variance_sum = 0;
+                variance_count = 0;
+            }
+            break;
+
+        case BENCH_MEASURING:
+            // Sample once per SysTick so every profile gets equal weight
+            if (ticks != last_tick) {
+                last_tick = ticks;
+                variance_sum += getAltVariance();
+                variance_count++;
+            }
+
+            if (ticks - phase_tick >= BENCH_MEASURE_TICKS) {
+                // Text would corrupt a binary telemetry stream
+                if (getTelemetryMode() == TELEMETRY_TEXT) {
+                    p = fmtStr(statusStr, "PWM ");
+                    p = fmtUint(p, getPWMProfileFreq(profile), 0);
+                    p = fmtStr(p, " Hz: var ");
+                    p = fmtUint(p, variance_sum / variance_count, 0);
+                    fmtStr(p, "\n\r");
+                    UARTSend(statusStr);
+                }
+
+                if (++profile < NUM_PWM_PROFILES) {
+                    beginProfile(ticks);
+                }
+                else {
+                    setPWMProfile(BENCH_RESTORE_PROFILE);
+                    phase = BENCH_IDLE;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return phase != BENCH_IDLE;
+}
@@ -0,0 +1,23 @@
+/*
+ * pwmBench.h
+ *
+ * PWM frequency sweep benchmark. Steps through each PWM frequency
+ * profile while flying and logs the altitude signal noise at each over
+ * UART, so the quietest frequency can be picked.
+ */
+
+#ifndef PWMBENCH_H_
+#define PWMBENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Start a sweep from the first profile. ticks is the current SysTick count.
+void startPWMBench(uint32_t ticks);
+
+// Advance the sweep; call every main loop pass while it runs. Returns
+// false once every profile has been measured and the original profile
+// restored.
+bool updatePWMBench(uint32_t ticks);
+
+#endif /* PWMBENCH_H_ */
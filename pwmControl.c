@@ -23,32 +23,59 @@
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
+#include "inc/hw_ints.h"
 
 #include "driverlib/pin_map.h" //Needed for pin configure
 #include "driverlib/debug.h"
 #include "driverlib/gpio.h"
 #include "driverlib/pwm.h"
 #include "driverlib/sysctl.h"
+#include "driverlib/interrupt.h"
 
 #include "pwmControl.h"
+#include "intPriority.h"
+#include "isrTiming.h"
 
 /**********************************************************
  * Constants
  **********************************************************/
 
-// PWM configuration
-#define PWM_DIVIDER_CODE        SYSCTL_PWMDIV_4
-#define PWM_DIVIDER             4
-#define PWM_CONST_FREQ          200
+// PWM configuration, used if initPWMClock() isn't called first
+#define PWM_DEFAULT_PROFILE     PWM_PROFILE_200HZ
 
 // Duty Cycle Configuration
 #define DUTY_CYCLE_MAX          100
 #define DUTY_CYCLE_START        0
+#define DUTY_PERMILLE_MAX       1000
+
+// Slew limits in permille of full scale per control tick (SysTick).
+// Soft-start applies from output enable until the output first catches
+// up with the command.
+#define MAIN_SLEW_PERMILLE      20      // 0 to 100% in 0.5 s
+#define MAIN_SOFT_PERMILLE      5       // 0 to 100% in 2 s
+#define TAIL_SLEW_PERMILLE      40      // 0 to 100% in 0.25 s
+#define TAIL_SOFT_PERMILLE      10      // 0 to 100% in 1 s
+
+// Motor kill input M0FAULT0: PD6, active low (pulled up). PD6 is also
+// the Orbit LED3 line, which this firmware doesn't use. The tail's
+// module only offers its fault input on PF4 (the LEFT button), so the
+// tail is cut by the fault interrupt instead.
+#define PWM_KILL_PERIPH_GPIO    SYSCTL_PERIPH_GPIOD
+#define PWM_KILL_GPIO_BASE      GPIO_PORTD_BASE
+#define PWM_KILL_GPIO_CONFIG    GPIO_PD6_M0FAULT0
+#define PWM_KILL_GPIO_PIN       GPIO_PIN_6
+
+// Passes averaged by benchRotorUpdate()
+#define ROTOR_BENCH_PASSES      64
+
+// Control ticks the main loop may go without kicking the watchdog
+#define MOTOR_WATCHDOG_TICKS    50      // 0.5 s at the 100 Hz SysTick
 
 //  PWM Hardware Details M0PWM7 (gen 3)
 //  ---Main Rotor PWM: PC5, J4-05
 #define PWM_MAIN_BASE           PWM0_BASE
 #define PWM_MAIN_GEN            PWM_GEN_3
+#define PWM_MAIN_GENBIT         PWM_GEN_3_BIT
 #define PWM_MAIN_OUTNUM         PWM_OUT_7
 #define PWM_MAIN_OUTBIT         PWM_OUT_7_BIT
 #define PWM_MAIN_PERIPH_PWM     SYSCTL_PERIPH_PWM0
@@ -61,6 +88,7 @@
 // --Tail Rotor PWM: PF1, J3-10
 #define PWM_TAIL_BASE           PWM1_BASE
 #define PWM_TAIL_GEN            PWM_GEN_2
+#define PWM_TAIL_GENBIT         PWM_GEN_2_BIT
 #define PWM_TAIL_OUTNUM         PWM_OUT_5
 #define PWM_TAIL_OUTBIT         PWM_OUT_5_BIT
 #define PWM_TAIL_PERIPH_PWM     SYSCTL_PERIPH_PWM1
@@ -69,6 +97,155 @@
 #define PWM_TAIL_GPIO_CONFIG    GPIO_PF1_M1PWM5
 #define PWM_TAIL_GPIO_PIN       GPIO_PIN_1
 
+/**********************************************************
+ * Globals to module
+ **********************************************************/
+// PWM period in PWM clock ticks, computed once by initPWMClock()
+static uint32_t g_ui32Period;
+
+// Last pulse widths written, so unchanged duties skip the register write
+static uint32_t g_ui32MainPulse;
+static uint32_t g_ui32TailPulse;
+
+// CPU cycles between starting the main and tail generators
+static uint32_t g_ui32StartSkew;
+
+// Slew limiter state for one rotor. All widths in PWM clock ticks.
+typedef struct {
+    bool ready;             // Generator initialised, safe to write
+    bool softStart;         // Ramping up after output enable
+    bool limited;           // Output held back from the command last tick
+    uint32_t step;          // Largest change per tick
+    uint32_t softStep;      // Largest rise per tick during soft-start
+    uint32_t target;        // Commanded pulse width
+    uint32_t output;        // Pulse width being driven
+} rotorSlew_t;
+
+static volatile rotorSlew_t g_mainSlew;
+static volatile rotorSlew_t g_tailSlew;
+
+// Frequency profiles, indexed by pwmProfiles. The divider is the
+// smallest that keeps the period inside the 16-bit counter at 20 MHz,
+// for the finest duty resolution.
+typedef struct {
+    uint32_t freq;          // PWM frequency, Hz
+    uint16_t divider;       // PWM clock divider
+} pwmProfile_t;
+
+static const pwmProfile_t g_pwmProfiles[NUM_PWM_PROFILES] = {
+    {200,  4},              // PWM_PROFILE_200HZ
+    {500,  1},              // PWM_PROFILE_500HZ
+    {1000, 1},              // PWM_PROFILE_1KHZ
+    {2000, 1},              // PWM_PROFILE_2KHZ
+    {5000, 1},              // PWM_PROFILE_5KHZ
+};
+
+// Set once the motors have been cut; cleared only by a reset
+static volatile bool g_bMotorKilled = false;
+
+// Control ticks since the main loop last kicked the watchdog, and
+// whether it has kicked at all yet
+static volatile uint16_t g_ui16WatchdogTicks;
+static volatile bool g_bWatchdogArmed = false;
+
+/*********************************************************
+ * pwmDividerCode
+ * Map a PWM clock divider to its SysCtl code, or 0 if the
+ * hardware doesn't support it.
+ *********************************************************/
+static uint32_t
+pwmDividerCode (uint16_t ui16Divider)
+{
+    switch (ui16Divider) {
+        case 1:  return SYSCTL_PWMDIV_1;
+        case 2:  return SYSCTL_PWMDIV_2;
+        case 4:  return SYSCTL_PWMDIV_4;
+        case 8:  return SYSCTL_PWMDIV_8;
+        case 16: return SYSCTL_PWMDIV_16;
+        case 32: return SYSCTL_PWMDIV_32;
+        case 64: return SYSCTL_PWMDIV_64;
+        default: return 0;
+    }
+}
+
+/*********************************************************
+ * initPWMClock
+ * Sets the PWM clock divider and computes the period once,
+ * so the duty setters don't need to call SysCtlClockGet().
+ * Call before initialiseMainPWM()/initialiseTailPWM().
+ * Returns false, leaving the clock untouched, if the
+ * combination can't be produced.
+ *********************************************************/
+bool
+initPWMClock (uint32_t ui32Freq, uint16_t ui16Divider)
+{
+    uint32_t ui32Code = pwmDividerCode(ui16Divider);
+    uint32_t ui32Period = pwmPeriodTicks(SysCtlClockGet(), ui32Freq, ui16Divider);
+
+    if (ui32Code == 0 || ui32Period == 0) {
+        return false;
+    }
+
+    SysCtlPWMClockSet(ui32Code);
+    g_ui32Period = ui32Period;
+
+    // Slew steps are fixed fractions of the period
+    g_mainSlew.step = ui32Period * MAIN_SLEW_PERMILLE / DUTY_PERMILLE_MAX;
+    g_mainSlew.softStep = ui32Period * MAIN_SOFT_PERMILLE / DUTY_PERMILLE_MAX;
+    g_tailSlew.step = ui32Period * TAIL_SLEW_PERMILLE / DUTY_PERMILLE_MAX;
+    g_tailSlew.softStep = ui32Period * TAIL_SOFT_PERMILLE / DUTY_PERMILLE_MAX;
+
+    return true;
+}
+
+// Period in PWM clock ticks; the full-scale value for the tick setters
+uint32_t
+getPWMPeriod (void)
+{
+    return g_ui32Period;
+}
+
+/********************************************************
+ * Write the pulse width of M0PWM7/M1PWM5 in PWM clock
+ * ticks (0 to getPWMPeriod()). Only the compare register
+ * is written, and only when the pulse width has changed.
+ * The new value is held until PWMSyncUpdate(). Returns
+ * true if it was written. The register and its cached
+ * copy must change together, so call from the control
+ * tick or with SysTick masked.
+ ********************************************************/
+static bool
+writeMainPulse (uint32_t ui32Pulse)
+{
+    if (ui32Pulse > g_ui32Period) {
+        ui32Pulse = g_ui32Period;
+    }
+
+    if (ui32Pulse == g_ui32MainPulse) {
+        return false;
+    }
+
+    PWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM, ui32Pulse);
+    g_ui32MainPulse = ui32Pulse;
+    return true;
+}
+
+static bool
+writeTailPulse (uint32_t ui32Pulse)
+{
+    if (ui32Pulse > g_ui32Period) {
+        ui32Pulse = g_ui32Period;
+    }
+
+    if (ui32Pulse == g_ui32TailPulse) {
+        return false;
+    }
+
+    PWMPulseWidthSet(PWM_TAIL_BASE, PWM_TAIL_OUTNUM, ui32Pulse);
+    g_ui32TailPulse = ui32Pulse;
+    return true;
+}
+
 /*********************************************************
  * initialisePWM
  * M0PWM7 (J4-05, PC5) is used for the main rotor motor
@@ -76,19 +253,36 @@
 void
 initialiseMainPWM (void)
 {
+    if (g_ui32Period == 0) {
+        initPWMClock(g_pwmProfiles[PWM_DEFAULT_PROFILE].freq,
+                     g_pwmProfiles[PWM_DEFAULT_PROFILE].divider);
+    }
+
     SysCtlPeripheralEnable(PWM_MAIN_PERIPH_PWM);
     SysCtlPeripheralEnable(PWM_MAIN_PERIPH_GPIO);
 
     GPIOPinConfigure(PWM_MAIN_GPIO_CONFIG);
     GPIOPinTypePWM(PWM_MAIN_GPIO_BASE, PWM_MAIN_GPIO_PIN);
 
+    // Period and compare writes are held until PWMSyncUpdate() and then
+    // latched at the next counter zero, so a duty change never lands
+    // part-way through a period. A fault stays latched until reset.
     PWMGenConfigure(PWM_MAIN_BASE, PWM_MAIN_GEN,
-                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
+                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_SYNC |
+                    PWM_GEN_MODE_GEN_SYNC_GLOBAL |
+                    PWM_GEN_MODE_FAULT_LATCHED | PWM_GEN_MODE_FAULT_EXT);
 
     // Set the initial PWM parameters
-    setMainPWM (DUTY_CYCLE_START);
+    PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, g_ui32Period);
+    g_ui32MainPulse = ~0;
+    writeMainPulse (DUTY_CYCLE_START);
+    PWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
 
-    PWMGenEnable(PWM_MAIN_BASE, PWM_MAIN_GEN);
+    g_mainSlew.target = DUTY_CYCLE_START;
+    g_mainSlew.output = DUTY_CYCLE_START;
+    g_mainSlew.ready = true;
+
+    // The counter is started by startRotorPWM()
 
     // Disable the output.  Repeat this call with 'true' to turn O/P on.
     PWMOutputState(PWM_MAIN_BASE, PWM_MAIN_OUTBIT, false);
@@ -97,6 +291,11 @@ initialiseMainPWM (void)
 void
 initialiseTailPWM (void)
 {
+    if (g_ui32Period == 0) {
+        initPWMClock(g_pwmProfiles[PWM_DEFAULT_PROFILE].freq,
+                     g_pwmProfiles[PWM_DEFAULT_PROFILE].divider);
+    }
+
     SysCtlPeripheralEnable(PWM_TAIL_PERIPH_PWM);
     SysCtlPeripheralEnable(PWM_TAIL_PERIPH_GPIO);
 
@@ -104,54 +303,474 @@ initialiseTailPWM (void)
     GPIOPinTypePWM(PWM_TAIL_GPIO_BASE, PWM_TAIL_GPIO_PIN);
 
     PWMGenConfigure(PWM_TAIL_BASE, PWM_TAIL_GEN,
-                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
+                    PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_SYNC |
+                    PWM_GEN_MODE_GEN_SYNC_GLOBAL);
 
     // Set the initial PWM parameters
-    setTailPWM (DUTY_CYCLE_START);
+    PWMGenPeriodSet(PWM_TAIL_BASE, PWM_TAIL_GEN, g_ui32Period);
+    g_ui32TailPulse = ~0;
+    writeTailPulse (DUTY_CYCLE_START);
+    PWMSyncUpdate(PWM_TAIL_BASE, PWM_TAIL_GENBIT);
 
-    PWMGenEnable(PWM_TAIL_BASE, PWM_TAIL_GEN);
+    g_tailSlew.target = DUTY_CYCLE_START;
+    g_tailSlew.output = DUTY_CYCLE_START;
+    g_tailSlew.ready = true;
 
     // Disable the output.  Repeat this call with 'true' to turn O/P on.
     PWMOutputState(PWM_TAIL_BASE, PWM_TAIL_OUTBIT, false);
 }
 
+/*********************************************************
+ * startRotorPWM
+ * Start both generator counters back to back with
+ * interrupts off. Main and tail are in separate PWM
+ * modules, which have no common sync, so this is the only
+ * thing that sets their relative phase. They stay apart
+ * by the CPU cycles between the two enables, measured
+ * here (getPWMStartSkew()); the modules share the PWM
+ * clock and period, so that offset then holds. Call after
+ * initialiseMainPWM() and initialiseTailPWM().
+ *********************************************************/
+void
+startRotorPWM (void)
+{
+    bool bWasMasked = IntMasterDisable();
+    uint32_t ui32Start = isrTimingStart();
+
+    PWMGenEnable(PWM_MAIN_BASE, PWM_MAIN_GEN);
+    PWMGenEnable(PWM_TAIL_BASE, PWM_TAIL_GEN);
+
+    g_ui32StartSkew = isrTimingStart() - ui32Start;
+
+    if (!bWasMasked) {
+        IntMasterEnable();
+    }
+}
+
+// CPU cycles between the two counters starting
+uint32_t
+getPWMStartSkew (void)
+{
+    return g_ui32StartSkew;
+}
+
+/********************************************************
+ * setPWMProfile
+ * Switch both generators to another frequency profile
+ * while running. Commands and outputs are rescaled to the
+ * new period so duties carry over. The divider changes
+ * at once while the new period waits for the period
+ * boundary, so expect one irregular period.
+ ********************************************************/
+bool
+setPWMProfile (uint8_t ui8Profile)
+{
+    uint32_t ui32Mask;
+    uint32_t ui32OldPeriod = g_ui32Period;
+    bool bOk;
+
+    if (ui8Profile >= NUM_PWM_PROFILES) {
+        return false;
+    }
+
+    // Hold off the control tick until the new period is consistent
+    ui32Mask = criticalEnter(INT_PRIORITY_SYSTICK);
+
+    bOk = initPWMClock(g_pwmProfiles[ui8Profile].freq,
+                       g_pwmProfiles[ui8Profile].divider);
+
+    if (bOk && ui32OldPeriod != 0) {
+        g_mainSlew.target = g_mainSlew.target * g_ui32Period / ui32OldPeriod;
+        g_mainSlew.output = g_mainSlew.output * g_ui32Period / ui32OldPeriod;
+        g_tailSlew.target = g_tailSlew.target * g_ui32Period / ui32OldPeriod;
+        g_tailSlew.output = g_tailSlew.output * g_ui32Period / ui32OldPeriod;
+
+        if (g_mainSlew.ready) {
+            PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, g_ui32Period);
+            g_ui32MainPulse = ~0;
+            writeMainPulse(g_mainSlew.output);
+        }
+        if (g_tailSlew.ready) {
+            PWMGenPeriodSet(PWM_TAIL_BASE, PWM_TAIL_GEN, g_ui32Period);
+            g_ui32TailPulse = ~0;
+            writeTailPulse(g_tailSlew.output);
+        }
+
+        PWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
+        PWMSyncUpdate(PWM_TAIL_BASE, PWM_TAIL_GENBIT);
+    }
+
+    criticalExit(ui32Mask);
+
+    return bOk;
+}
+
+// Frequency of a profile in Hz, or 0 if there is no such profile
+uint32_t
+getPWMProfileFreq (uint8_t ui8Profile)
+{
+    if (ui8Profile >= NUM_PWM_PROFILES) {
+        return 0;
+    }
+
+    return g_pwmProfiles[ui8Profile].freq;
+}
+
+/********************************************************
+ * Motor kill. Cuts both outputs and latches the killed
+ * state; nothing re-enables them short of a reset. Safe
+ * to call from any context.
+ ********************************************************/
+void
+motorKill (void)
+{
+    g_bMotorKilled = true;
+
+    PWMOutputState(PWM_MAIN_BASE, PWM_MAIN_OUTBIT, false);
+    PWMOutputState(PWM_TAIL_BASE, PWM_TAIL_OUTBIT, false);
+}
+
+// True once the motors have been cut by the kill input or motorKill()
+bool
+isMotorKilled (void)
+{
+    return g_bMotorKilled;
+}
+
+/********************************************************
+ * Fault interrupt for the kill input. By the time this
+ * runs the hardware has already forced the main rotor
+ * low; cut the tail and flag the kill for the main loop.
+ ********************************************************/
+static void
+motorKillHandler (void)
+{
+    PWMFaultIntClearExt(PWM_MAIN_BASE, PWM_INT_FAULT0);
+    motorKill();
+}
+
+/********************************************************
+ * initMotorKill
+ * Routes the kill input to the main rotor generator's
+ * fault logic, so the output is driven low within a PWM
+ * cycle with no software involved. Call after
+ * initialiseMainPWM() and initialiseTailPWM().
+ ********************************************************/
+void
+initMotorKill (void)
+{
+    SysCtlPeripheralEnable(PWM_KILL_PERIPH_GPIO);
+
+    GPIOPinConfigure(PWM_KILL_GPIO_CONFIG);
+    GPIOPinTypePWM(PWM_KILL_GPIO_BASE, PWM_KILL_GPIO_PIN);
+    GPIOPadConfigSet(PWM_KILL_GPIO_BASE, PWM_KILL_GPIO_PIN, GPIO_STRENGTH_2MA,
+                     GPIO_PIN_TYPE_STD_WPU);
+
+    PWMGenFaultConfigure(PWM_MAIN_BASE, PWM_MAIN_GEN, 0, PWM_FAULT0_SENSE_LOW);
+    PWMGenFaultTriggerSet(PWM_MAIN_BASE, PWM_MAIN_GEN, PWM_FAULT_GROUP_0,
+                          PWM_FAULT_FAULT0);
+
+    // Drive the output low while the fault is active
+    PWMOutputFaultLevel(PWM_MAIN_BASE, PWM_MAIN_OUTBIT, false);
+    PWMOutputFault(PWM_MAIN_BASE, PWM_MAIN_OUTBIT, true);
+
+    PWMFaultIntRegister(PWM_MAIN_BASE, motorKillHandler);
+    PWMIntEnable(PWM_MAIN_BASE, PWM_INT_FAULT0);
+    IntPrioritySet(INT_PWM0_FAULT, INT_PRIORITY_MOTOR_KILL);
+    IntEnable(INT_PWM0_FAULT);
+}
+
+/********************************************************
+ * Software watchdog on the main loop. The loop kicks it
+ * every pass; the control tick kills the motors if it
+ * hasn't been kicked for MOTOR_WATCHDOG_TICKS.
+ ********************************************************/
+void
+kickMotorWatchdog (void)
+{
+    g_ui16WatchdogTicks = 0;
+    g_bWatchdogArmed = true;
+}
+
+static void
+checkMotorWatchdog (void)
+{
+    if (g_bWatchdogArmed && ++g_ui16WatchdogTicks >= MOTOR_WATCHDOG_TICKS) {
+        motorKill();
+    }
+}
+
+/********************************************************
+ * Restart a rotor from zero. On enable it soft-starts
+ * from there; on disable it is left at zero ready for
+ * the next enable. Call with SysTick masked, together
+ * with the zero pulse write, so the control tick can't
+ * write a pulse between the two.
+ ********************************************************/
+static void
+restartSlew (volatile rotorSlew_t *slew, bool bSoftStart)
+{
+    slew->output = 0;
+    slew->softStart = bSoftStart;
+    slew->limited = bSoftStart;
+}
+
 // Turn on/off the main PWM generator
 void setMainPWMOutput(uint16_t main_output)
 {
+    // The control tick also writes the pulse and its cache, so zero
+    // both without it running
+    uint32_t ui32Mask = criticalEnter(INT_PRIORITY_SYSTICK);
+
+    restartSlew(&g_mainSlew, main_output);
+    if (writeMainPulse(0)) {
+        PWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
+    }
+
+    criticalExit(ui32Mask);
+
     // Disable the output.  Repeat this call with 'true' to turn O/P on.
-    PWMOutputState(PWM_MAIN_BASE, PWM_MAIN_OUTBIT, main_output);
+    // Once killed, the output stays off; check again afterwards in case
+    // the kill landed between the two.
+    PWMOutputState(PWM_MAIN_BASE, PWM_MAIN_OUTBIT,
+                   main_output && !g_bMotorKilled);
+    if (g_bMotorKilled) {
+        PWMOutputState(PWM_MAIN_BASE, PWM_MAIN_OUTBIT, false);
+    }
 }
 
 // turn on/off the tail PWM generator
 void setTailPWMOutput(uint16_t tail_output)
 {
+    uint32_t ui32Mask = criticalEnter(INT_PRIORITY_SYSTICK);
+
+    restartSlew(&g_tailSlew, tail_output);
+    if (writeTailPulse(0)) {
+        PWMSyncUpdate(PWM_TAIL_BASE, PWM_TAIL_GENBIT);
+    }
+
+    criticalExit(ui32Mask);
+
     // Disable the output.  Repeat this call with 'true' to turn O/P on.
-    PWMOutputState(PWM_TAIL_BASE, PWM_TAIL_OUTBIT, tail_output);
+    PWMOutputState(PWM_TAIL_BASE, PWM_TAIL_OUTBIT,
+                   tail_output && !g_bMotorKilled);
+    if (g_bMotorKilled) {
+        PWMOutputState(PWM_TAIL_BASE, PWM_TAIL_OUTBIT, false);
+    }
+}
+
+/********************************************************
+ * Move a rotor's output one tick towards its command,
+ * by at most its step (or soft-start step going up).
+ * Constant time; no multiply or divide.
+ ********************************************************/
+static void
+stepSlew (volatile rotorSlew_t *slew)
+{
+    uint32_t ui32Target = slew->target;
+    uint32_t ui32Output = slew->output;
+    uint32_t ui32Rise = slew->softStart ? slew->softStep : slew->step;
+
+    if (ui32Target > ui32Output + ui32Rise) {
+        slew->output = ui32Output + ui32Rise;
+        slew->limited = true;
+    }
+    else if (ui32Target + slew->step < ui32Output) {
+        slew->output = ui32Output - slew->step;
+        slew->limited = true;
+    }
+    else {
+        slew->output = ui32Target;
+        slew->limited = false;
+        slew->softStart = false;
+    }
+}
+
+// Write both slewed outputs, then release whichever changed
+static void
+writeRotorOutputs (void)
+{
+    bool bMain = false;
+    bool bTail = false;
+
+    if (g_mainSlew.ready) {
+        bMain = writeMainPulse(g_mainSlew.output);
+    }
+    if (g_tailSlew.ready) {
+        bTail = writeTailPulse(g_tailSlew.output);
+    }
+
+    if (bMain) {
+        PWMSyncUpdate(PWM_MAIN_BASE, PWM_MAIN_GENBIT);
+    }
+    if (bTail) {
+        PWMSyncUpdate(PWM_TAIL_BASE, PWM_TAIL_GENBIT);
+    }
 }
 
 /********************************************************
- * Function to set the freq, duty cycle of M0PWM7
+ * Control tick: slew both rotors and write the result.
+ * Called from the SysTick handler. Both compare registers
+ * are written before either update is released, and the
+ * two releases are back to back. Each generator latches
+ * at its own counter zero; startRotorPWM() started the
+ * counters within getPWMStartSkew() cycles, so the zeros
+ * are that far apart. The pair therefore latch in the
+ * same period unless a zero falls in the few cycles
+ * between the two releases (plus that skew), in which
+ * case the tail latches one period after the main. They
+ * are never more than one period apart.
  ********************************************************/
 void
-setMainPWM (uint16_t ui16Duty)
+updateRotorSlew (void)
+{
+    checkMotorWatchdog();
+
+    if (g_mainSlew.ready) {
+        stepSlew(&g_mainSlew);
+    }
+    if (g_tailSlew.ready) {
+        stepSlew(&g_tailSlew);
+    }
+
+    writeRotorOutputs();
+}
+
+// True if the limiter held the output back from the command last tick
+bool
+isMainSlewLimited (void)
 {
-    // Calculate the PWM period corresponding to the freq.
-    uint32_t ui32Period =
-        SysCtlClockGet() / PWM_DIVIDER / PWM_CONST_FREQ;
+    return g_mainSlew.limited;
+}
 
-    PWMGenPeriodSet(PWM_MAIN_BASE, PWM_MAIN_GEN, ui32Period);
-    PWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM,
-        ui32Period * ui16Duty / 100);
+bool
+isTailSlewLimited (void)
+{
+    return g_tailSlew.limited;
 }
 
+/********************************************************
+ * benchRotorUpdate
+ * Average CPU cycles for the main loop's rotor command,
+ * setRotorPermille(), plus the control tick's register
+ * write. With cached false the compare caches are
+ * cleared each pass, so every pass writes and syncs both
+ * generators, as before the cache. The rotors are
+ * re-commanded their current duties and the outputs are
+ * rewritten unchanged; the control tick is held off
+ * throughout and the commands are restored after.
+ ********************************************************/
+uint32_t
+benchRotorUpdate (bool cached)
+{
+    uint32_t ui32Mask;
+    uint32_t ui32MainTarget;
+    uint32_t ui32TailTarget;
+    uint16_t ui16MainPermille = 0;
+    uint16_t ui16TailPermille = 0;
+    uint32_t start;
+    uint32_t cycles;
+    uint8_t i;
+
+    ui32Mask = criticalEnter(INT_PRIORITY_SYSTICK);
+
+    ui32MainTarget = g_mainSlew.target;
+    ui32TailTarget = g_tailSlew.target;
+    if (g_ui32Period != 0) {
+        ui16MainPermille = ui32MainTarget * DUTY_PERMILLE_MAX / g_ui32Period;
+        ui16TailPermille = ui32TailTarget * DUTY_PERMILLE_MAX / g_ui32Period;
+    }
+
+    start = isrTimingStart();
+    for (i = 0; i < ROTOR_BENCH_PASSES; i++) {
+        if (!cached) {
+            g_ui32MainPulse = ~0;
+            g_ui32TailPulse = ~0;
+        }
+        setRotorPermille(ui16MainPermille, ui16TailPermille);
+        writeRotorOutputs();
+    }
+    cycles = isrTimingStart() - start;
+
+    g_mainSlew.target = ui32MainTarget;
+    g_tailSlew.target = ui32TailTarget;
+
+    criticalExit(ui32Mask);
+
+    return cycles / ROTOR_BENCH_PASSES;
+}
+
+/********************************************************
+ * Command pulse widths in PWM clock ticks (0 to
+ * getPWMPeriod()). The outputs follow at the slew rate
+ * on the next control ticks.
+ ********************************************************/
 void
-setTailPWM (uint16_t ui16Duty)
+setMainPWMTicks (uint32_t ui32Pulse)
 {
-    // Calculate the PWM period corresponding to the freq.
-    uint32_t ui32Period =
-        SysCtlClockGet() / PWM_DIVIDER / PWM_CONST_FREQ;
+    g_mainSlew.target = (ui32Pulse > g_ui32Period) ? g_ui32Period : ui32Pulse;
+}
+
+void
+setTailPWMTicks (uint32_t ui32Pulse)
+{
+    g_tailSlew.target = (ui32Pulse > g_ui32Period) ? g_ui32Period : ui32Pulse;
+}
+
+// Command both rotors so the pair is picked up by the same control tick
+void
+setRotorTicks (uint32_t ui32MainPulse, uint32_t ui32TailPulse)
+{
+    uint32_t ui32Mask = criticalEnter(INT_PRIORITY_SYSTICK);
+
+    setMainPWMTicks(ui32MainPulse);
+    setTailPWMTicks(ui32TailPulse);
+
+    criticalExit(ui32Mask);
+}
+
+// Both rotor duties in permille (0 to 1000)
+void
+setRotorPermille (uint16_t ui16MainPermille, uint16_t ui16TailPermille)
+{
+    setRotorTicks(pwmDutyTicks(g_ui32Period, ui16MainPermille, DUTY_PERMILLE_MAX),
+                  pwmDutyTicks(g_ui32Period, ui16TailPermille, DUTY_PERMILLE_MAX));
+}
 
-    PWMGenPeriodSet(PWM_TAIL_BASE, PWM_TAIL_GEN, ui32Period);
-    PWMPulseWidthSet(PWM_TAIL_BASE, PWM_TAIL_OUTNUM,
-        ui32Period * ui16Duty / 100);
+// Both rotor duties in percent (0 to 100)
+void
+setRotorDuties (uint16_t ui16MainDuty, uint16_t ui16TailDuty)
+{
+    setRotorTicks(pwmDutyTicks(g_ui32Period, ui16MainDuty, DUTY_CYCLE_MAX),
+                  pwmDutyTicks(g_ui32Period, ui16TailDuty, DUTY_CYCLE_MAX));
+}
+
+/********************************************************
+ * Duty cycle in permille (0 to 1000)
+ ********************************************************/
+void
+setMainPWMPermille (uint16_t ui16Permille)
+{
+    setMainPWMTicks(pwmDutyTicks(g_ui32Period, ui16Permille, DUTY_PERMILLE_MAX));
+}
+
+void
+setTailPWMPermille (uint16_t ui16Permille)
+{
+    setTailPWMTicks(pwmDutyTicks(g_ui32Period, ui16Permille, DUTY_PERMILLE_MAX));
+}
+
+/********************************************************
+ * Duty cycle in percent (0 to 100)
+ ********************************************************/
+void
+setMainPWM (uint16_t ui16Duty)
+{
+    setMainPWMTicks(pwmDutyTicks(g_ui32Period, ui16Duty, DUTY_CYCLE_MAX));
+}
+
+void
+setTailPWM (uint16_t ui16Duty)
+{
+    setTailPWMTicks(pwmDutyTicks(g_ui32Period, ui16Duty, DUTY_CYCLE_MAX));
 }
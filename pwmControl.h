@@ -2,17 +2,108 @@
 #define PWMCONTROL_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+// Period limits in PWM clock ticks. The generator counters are 16 bits
+// wide, and a whole-percent duty needs at least 100 ticks.
+#define PWM_PERIOD_MAX          0xFFFF
+#define PWM_PERIOD_MIN          100
+
+// PWM period in PWM clock ticks for the given system clock, frequency
+// and divider, rounded down, or 0 if it is outside the limits above.
+// In pwmPeriod.c, which has no hardware access, so tests/ builds it.
+uint32_t pwmPeriodTicks (uint32_t ui32SysClock, uint32_t ui32Freq, uint16_t ui16Divider);
+
+// Pulse width in ticks for a duty of duty parts in full (1000 for
+// permille), rounded down; full scale or more gives the whole period.
+// full must be at most 65536. Also in pwmPeriod.c.
+uint32_t pwmDutyTicks (uint32_t ui32Period, uint32_t ui32Duty, uint32_t ui32Full);
+
+// Set the PWM frequency (Hz) and clock divider (1, 2, 4 ... 64). Call
+// before the initialise functions; they default to 200 Hz, divide by 4.
+bool initPWMClock (uint32_t ui32Freq, uint16_t ui16Divider);
+
+// Period in PWM clock ticks; the full-scale value for the tick setters
+uint32_t getPWMPeriod (void);
+
+// Frequency profiles selectable while running
+enum pwmProfiles {PWM_PROFILE_200HZ = 0, PWM_PROFILE_500HZ, PWM_PROFILE_1KHZ,
+                  PWM_PROFILE_2KHZ, PWM_PROFILE_5KHZ, NUM_PWM_PROFILES};
+
+// Switch both generators to a profile, keeping the current duties
+bool setPWMProfile (uint8_t ui8Profile);
+
+// Frequency of a profile in Hz, or 0 if there is no such profile
+uint32_t getPWMProfileFreq (uint8_t ui8Profile);
 
 void initialiseMainPWM (void);
 
 void initialiseTailPWM (void);
 
+// Start both generators together, after both are initialised. Main and
+// tail are separate PWM modules; their counters run offset by the CPU
+// cycles between the two starts, which getPWMStartSkew() returns.
+void startRotorPWM (void);
+
+uint32_t getPWMStartSkew (void);
+
+// Duty commands. Outputs follow at the slew rate on the next control
+// ticks (updateRotorSlew).
+
+// Duty as a pulse width in PWM clock ticks (0 to getPWMPeriod())
+void setMainPWMTicks (uint32_t ui32Pulse);
+
+void setTailPWMTicks (uint32_t ui32Pulse);
+
+// Duty in permille (0 to 1000)
+void setMainPWMPermille (uint16_t ui16Permille);
+
+void setTailPWMPermille (uint16_t ui16Permille);
+
+// Duty in percent (0 to 100)
 void setMainPWM (uint16_t ui16Duty);
 
 void setTailPWM (uint16_t ui16Duty);
 
+// Command both rotors together, so the pair is picked up by the same
+// control tick. Main and tail then latch in the same PWM period, or at
+// worst one period apart; see updateRotorSlew() in pwmControl.c.
+void setRotorTicks (uint32_t ui32MainPulse, uint32_t ui32TailPulse);
+
+void setRotorPermille (uint16_t ui16MainPermille, uint16_t ui16TailPermille);
+
+void setRotorDuties (uint16_t ui16MainDuty, uint16_t ui16TailDuty);
+
+// Average CPU cycles to command both rotors and write the compares,
+// with the unchanged-compare skip (cached) or forcing every write
+uint32_t benchRotorUpdate (bool cached);
+
+// Output enable. Enabling soft-starts the rotor from zero.
 void setMainPWMOutput(uint16_t main_output);
 
 void setTailPWMOutput(uint16_t tail_output);
 
+// Motor kill. initMotorKill() routes the kill input (PD6, active low)
+// to the PWM fault logic; motorKill() cuts both outputs from software.
+// Either way the outputs stay off until reset.
+void initMotorKill (void);
+
+void motorKill (void);
+
+bool isMotorKilled (void);
+
+// Software watchdog: call every main loop pass. If the loop stalls for
+// longer than the limit, the control tick kills the motors.
+void kickMotorWatchdog (void);
+
+// Control tick: slew the outputs towards their commands and write them.
+// Call from the SysTick handler.
+void updateRotorSlew (void);
+
+// True if the limiter held the output back from the command last tick,
+// so the controller can stop integrating
+bool isMainSlewLimited (void);
+
+bool isTailSlewLimited (void);
+
 #endif
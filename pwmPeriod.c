@@ -0,0 +1,60 @@
+/*
+ * pwmPeriod.c
+ *
+ * PWM period and duty arithmetic. Plain integer code with no hardware
+ * access, kept out of pwmControl.c so the host tests can build it.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pwmControl.h"
+
+/*********************************************************
+ * pwmPeriodTicks
+ * PWM period in PWM clock ticks for the given system clock,
+ * frequency and divider, rounded down. Returns 0 if the
+ * period doesn't fit the 16-bit generator counter or is
+ * too short to be useful.
+ *********************************************************/
+uint32_t
+pwmPeriodTicks (uint32_t ui32SysClock, uint32_t ui32Freq, uint16_t ui16Divider)
+{
+    uint32_t ui32Period;
+
+    if (ui32Freq == 0 || ui16Divider == 0) {
+        return 0;
+    }
+
+    // Dividing twice rounds down the same as dividing by the product,
+    // without the product overflowing
+    ui32Period = ui32SysClock / ui16Divider / ui32Freq;
+
+    if (ui32Period > PWM_PERIOD_MAX || ui32Period < PWM_PERIOD_MIN) {
+        return 0;
+    }
+
+    return ui32Period;
+}
+
+/*********************************************************
+ * pwmDutyTicks
+ * Pulse width in PWM clock ticks for a duty of ui32Duty
+ * parts in ui32Full (permille: ui32Full = 1000), rounded
+ * down. A duty at or above full scale gives the whole
+ * period. The period is at most PWM_PERIOD_MAX, so the
+ * product fits 32 bits for any ui32Full up to 65536.
+ *********************************************************/
+uint32_t
+pwmDutyTicks (uint32_t ui32Period, uint32_t ui32Duty, uint32_t ui32Full)
+{
+    if (ui32Full == 0) {
+        return 0;
+    }
+
+    if (ui32Duty >= ui32Full) {
+        return ui32Period;
+    }
+
+    return ui32Period * ui32Duty / ui32Full;
+}
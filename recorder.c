@@ -0,0 +1,242 @@
+/*
+ * recorder.c
+ *
+ * Flight recorder in a reserved SRAM section. See recorder.h for the
+ * record and dump formats.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "recorder.h"
+#include "telemetry.h"
+#include "flashLog.h"
+
+//**********************************************************************
+// Constants
+//**********************************************************************
+#define RECORDER_MAGIC          0x424C4B31  // "BLK1"
+#define RECORDER_HEADER_LEN     8
+#define RECORDER_FIELDS         8
+#define RECORDER_MAX_RECORD     ((1 + RECORDER_FIELDS) * 5)
+#define RECORDER_SIZE           (RECORDER_BLOCKS * RECORDER_BLOCK_SIZE)
+
+//**********************************************************************
+// The recording. Lives in .blackbox, which the linker command file
+// leaves uninitialised so it survives a warm reset.
+//**********************************************************************
+typedef struct {
+    uint32_t magic;
+    uint32_t cause;                     // Non-zero once frozen
+    uint32_t sequence;                  // Of the block being written
+    uint32_t block;                     // Index of the block being written
+    uint32_t offset;                    // Next free byte in that block
+    uint32_t timestamp;                 // Of the latest record
+    int32_t prev[RECORDER_FIELDS];      // Field values of the latest record
+    uint8_t data[RECORDER_SIZE];
+} recorder_t;
+
+#pragma DATA_SECTION(g_recorder, ".blackbox")
+static recorder_t g_recorder;
+
+static bool g_dumping;
+static bool g_dumpInfoSent;
+static uint16_t g_dumpOffset;
+
+//**********************************************************************
+// Encoding
+//**********************************************************************
+static uint8_t *putVarint(uint8_t *p, uint32_t v)
+{
+    while (v >= 0x80) {
+        *p++ = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    *p++ = v;
+    return p;
+}
+
+// Map signed to unsigned so small changes either way stay short
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+// Start a new block, overwriting the oldest
+static void startBlock(uint32_t timestamp)
+{
+    uint8_t *block;
+    uint16_t i;
+
+    // Persist the block just finished
+    if (g_recorder.sequence != 0) {
+        flashLogAppend(&g_recorder.data[g_recorder.block * RECORDER_BLOCK_SIZE]);
+    }
+
+    g_recorder.block = (g_recorder.block + 1) % RECORDER_BLOCKS;
+    g_recorder.sequence++;
+    block = &g_recorder.data[g_recorder.block * RECORDER_BLOCK_SIZE];
+
+    for (i = RECORDER_HEADER_LEN; i < RECORDER_BLOCK_SIZE; i++) {
+        block[i] = 0;
+    }
+    putU32(block, g_recorder.sequence);
+    putU32(block + 4, timestamp);
+
+    g_recorder.offset = RECORDER_HEADER_LEN;
+    g_recorder.timestamp = timestamp - 1;
+    for (i = 0; i < RECORDER_FIELDS; i++) {
+        g_recorder.prev[i] = 0;
+    }
+}
+
+//**********************************************************************
+// Recording
+//**********************************************************************
+void initRecorder(void)
+{
+    // A frozen recording from before a warm reset is kept for dumping
+    if (g_recorder.magic == RECORDER_MAGIC && g_recorder.cause != REC_CAUSE_NONE
+        && g_recorder.block < RECORDER_BLOCKS) {
+        return;
+    }
+
+    recorderClear();
+}
+
+void recorderClear(void)
+{
+    uint16_t i;
+
+    g_dumping = false;
+
+    for (i = 0; i < RECORDER_BLOCKS; i++) {
+        putU32(&g_recorder.data[i * RECORDER_BLOCK_SIZE], 0);
+    }
+    g_recorder.cause = REC_CAUSE_NONE;
+    g_recorder.sequence = 0;
+    g_recorder.block = RECORDER_BLOCKS - 1;
+    g_recorder.offset = RECORDER_BLOCK_SIZE;    // Full, so the next log starts block 0
+    g_recorder.magic = RECORDER_MAGIC;
+}
+
+void recorderLog(uint32_t timestamp, uint16_t main_duty, uint16_t tail_duty,
+    int16_t altitude, int16_t desired_alt, int16_t yaw, int16_t desired_yaw,
+    uint8_t mode, uint32_t loop_cycles)
+{
+    uint8_t record[RECORDER_MAX_RECORD];
+    int32_t fields[RECORDER_FIELDS];
+    uint32_t delta;
+    uint8_t *p;
+    volatile uint8_t *dst;
+    uint16_t len;
+    uint8_t i;
+
+    if (g_recorder.cause != REC_CAUSE_NONE
+        || timestamp == g_recorder.timestamp) {
+        return;
+    }
+
+    if (g_recorder.offset + RECORDER_MAX_RECORD > RECORDER_BLOCK_SIZE) {
+        startBlock(timestamp);
+    }
+
+    fields[0] = altitude;
+    fields[1] = desired_alt;
+    fields[2] = yaw;
+    fields[3] = desired_yaw;
+    fields[4] = main_duty;
+    fields[5] = tail_duty;
+    fields[6] = mode;
+    fields[7] = loop_cycles;
+
+    // Changes are taken modulo 2^32 so a large loop cycle count can't
+    // overflow; the decoder masks that field back to 32 bits
+    p = putVarint(record, timestamp - g_recorder.timestamp);
+    for (i = 0; i < RECORDER_FIELDS; i++) {
+        delta = (uint32_t)fields[i] - (uint32_t)g_recorder.prev[i];
+        p = putVarint(p, zigzag((int32_t)delta));
+        g_recorder.prev[i] = fields[i];
+    }
+    g_recorder.timestamp = timestamp;
+
+    // Copy the first byte last. Until it is written the block still
+    // ends in a zero there, so a freeze and reset part-way through the
+    // copy leaves no half record for the decoder. Volatile keeps the
+    // stores in that order.
+    len = p - record;
+    dst = &g_recorder.data[g_recorder.block * RECORDER_BLOCK_SIZE + g_recorder.offset];
+    for (i = 1; i < len; i++) {
+        dst[i] = record[i];
+    }
+    dst[0] = record[0];
+    g_recorder.offset += len;
+}
+
+void recorderFreeze(uint8_t cause)
+{
+    if (g_recorder.cause == REC_CAUSE_NONE) {
+        g_recorder.cause = cause;
+
+        // Persist the part-filled block too
+        if (g_recorder.sequence != 0) {
+            flashLogAppend(&g_recorder.data[g_recorder.block * RECORDER_BLOCK_SIZE]);
+        }
+    }
+}
+
+uint8_t getRecorderCause(void)
+{
+    return g_recorder.cause;
+}
+
+//**********************************************************************
+// Dumping
+//**********************************************************************
+void recorderStartDump(void)
+{
+    recorderFreeze(REC_CAUSE_COMMAND);
+
+    g_dumping = true;
+    g_dumpInfoSent = false;
+    g_dumpOffset = 0;
+}
+
+void recorderPoll(void)
+{
+    uint8_t frame[3 + RECORDER_DUMP_CHUNK + TELEMETRY_CRC_LEN];
+    uint8_t *p;
+    uint16_t len;
+    uint16_t i;
+
+    if (!g_dumping) {
+        return;
+    }
+
+    if (!g_dumpInfoSent) {
+        frame[0] = TELEMETRY_TYPE_REC_INFO;
+        frame[1] = g_recorder.cause;
+        p = putU16(frame + 2, RECORDER_BLOCK_SIZE);
+        p = putU16(p, RECORDER_BLOCKS);
+        g_dumpInfoSent = telemetrySubmit(frame, p - frame, sizeof(frame));
+        return;
+    }
+
+    len = RECORDER_SIZE - g_dumpOffset;
+    if (len > RECORDER_DUMP_CHUNK) {
+        len = RECORDER_DUMP_CHUNK;
+    }
+
+    frame[0] = TELEMETRY_TYPE_REC_DATA;
+    p = putU16(frame + 1, g_dumpOffset);
+    for (i = 0; i < len; i++) {
+        *p++ = g_recorder.data[g_dumpOffset + i];
+    }
+
+    if (telemetrySubmit(frame, p - frame, sizeof(frame))) {
+        g_dumpOffset += len;
+        if (g_dumpOffset >= RECORDER_SIZE) {
+            g_dumping = false;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * recorder.h
+ *
+ * Flight recorder ("black box"). Logs one compact record per control
+ * tick into a ring in a reserved, uninitialised SRAM section, so the
+ * contents survive a warm reset. Recording stops when the recorder is
+ * frozen -- by a motor kill, the REC FREEZE command or the reset
+ * button -- and only a frozen recording is kept at start-up, so it
+ * can be dumped over the UART afterwards. A debugger reset doesn't
+ * freeze it and starts a new recording. tools/blackbox_decode.py turns a
+ * dump into CSV. Finished blocks, and the last one when frozen, are
+ * also copied to the flash log (flashLog.h) to survive a power cycle.
+ *
+ * The ring is RECORDER_BLOCKS blocks of RECORDER_BLOCK_SIZE bytes and
+ * wraps a whole block at a time. Each block is:
+ *   0  uint32  block sequence number, 0 = empty
+ *   4  uint32  timestamp of the first record, SysTick counts
+ *   8  ...     records, then zero fill
+ *
+ * Each record is a series of varints (7 bits per byte, least
+ * significant first, top bit set on all but the last byte):
+ *   ticks since the previous record -- never zero, so a zero byte
+ *     ends the block. The first record in a block counts from one
+ *     tick before the block timestamp.
+ *   then, zigzag encoded, the change since the previous record of:
+ *     altitude, desired altitude, yaw, desired yaw, main duty,
+ *     tail duty, mode and loop cycles.
+ * The first record in a block is relative to all zeros, so every block
+ * decodes on its own.
+ *
+ * A dump is a run of telemetry frames (see telemetry.h): one
+ * TELEMETRY_TYPE_REC_INFO frame, then TELEMETRY_TYPE_REC_DATA frames
+ * covering the whole ring in order.
+ *   REC_INFO:  uint8 type, uint8 freeze cause, uint16 block size,
+ *              uint16 block count, uint16 CRC
+ *   REC_DATA:  uint8 type, uint16 byte offset into the ring,
+ *              RECORDER_DUMP_CHUNK bytes, uint16 CRC
+ */
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define RECORDER_BLOCK_SIZE     256
+#define RECORDER_BLOCKS         32      // 8 kB, about 7 s of flight
+#define RECORDER_DUMP_CHUNK     48      // Fits a UART DMA buffer once encoded
+
+enum recorderCauses {REC_CAUSE_NONE = 0, REC_CAUSE_COMMAND, REC_CAUSE_KILL,
+                     REC_CAUSE_RESET, REC_CAUSE_ORIENT};
+
+// Keep a frozen recording left by a warm reset, otherwise start empty.
+// Call once at start-up.
+void initRecorder(void);
+
+// Log one record. Call every main loop pass; only the first call in
+// each SysTick is recorded. Does nothing while frozen.
+void recorderLog(uint32_t timestamp, uint16_t main_duty, uint16_t tail_duty,
+    int16_t altitude, int16_t desired_alt, int16_t yaw, int16_t desired_yaw,
+    uint8_t mode, uint32_t loop_cycles);
+
+// Stop recording. The first cause is kept. Safe to call from an
+// interrupt that preempts recorderLog().
+void recorderFreeze(uint8_t cause);
+
+// Return the freeze cause, or REC_CAUSE_NONE while recording
+uint8_t getRecorderCause(void);
+
+// Discard the recording and start again
+void recorderClear(void);
+
+// Freeze, if not already, and start dumping over the UART
+void recorderStartDump(void);
+
+// Send the next part of a dump, if a UART DMA buffer is free. Call
+// every main loop pass; never blocks.
+void recorderPoll(void);
+
+#endif /* RECORDER_H_ */
@@ -17,10 +17,14 @@
 #include "driverlib/sysctl.h"
 
 #include "reset.h"
+#include "intPriority.h"
+#include "recorder.h"
 
-// Interrupt handler for the reset button
+// Interrupt handler for the reset button. Freezing the flight recorder
+// first keeps its ring across the reset for dumping afterwards.
 static void ResetHandler(void) {
     GPIOIntClear(GPIO_PORTA_BASE, GPIO_PIN_6);
+    recorderFreeze(REC_CAUSE_RESET);
     SysCtlReset();
 }
 
@@ -35,5 +39,6 @@ void initReset(void) {
     GPIOIntTypeSet(GPIO_PORTA_BASE, GPIO_PIN_6, GPIO_FALLING_EDGE);
     GPIOIntRegister(GPIO_PORTA_BASE, ResetHandler);
     GPIOIntEnable(GPIO_PORTA_BASE, GPIO_PIN_6);
+    IntPrioritySet(INT_GPIOA, INT_PRIORITY_RESET);
     IntEnable(INT_GPIOA);
 }
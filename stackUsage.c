@@ -0,0 +1,49 @@
+/*
+ * stackUsage.c
+ *
+ * Stack high-water mark, by filling the unused stack with a pattern
+ * and finding the lowest word overwritten.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stackUsage.h"
+
+#define STACK_FILL              0xA5A5A5A5
+#define STACK_FILL_MARGIN       16      // Words left clear below the caller
+
+// Bottom and top of the stack section, from the linker command file
+extern uint32_t __stack;
+extern uint32_t __STACK_TOP;
+
+// Fill from the bottom of the stack to a little below this frame
+void initStackUsage(void)
+{
+    volatile uint32_t marker;
+    uint32_t *p = &__stack;
+    uint32_t *end = (uint32_t *)&marker - STACK_FILL_MARGIN;
+
+    while (p < end) {
+        *p++ = STACK_FILL;
+    }
+}
+
+// The stack grows down, so the deepest use is the lowest changed word.
+// A frame that happens to leave the pattern in place is missed, so
+// this can under-read by a word or two.
+uint32_t getStackUsed(void)
+{
+    const uint32_t *p = &__stack;
+
+    while (p < &__STACK_TOP && *p == STACK_FILL) {
+        p++;
+    }
+
+    return (&__STACK_TOP - p) * sizeof(uint32_t);
+}
+
+uint32_t getStackSize(void)
+{
+    return (&__STACK_TOP - &__stack) * sizeof(uint32_t);
+}
@@ -0,0 +1,25 @@
+/*
+ * stackUsage.h
+ *
+ * Stack high-water mark. The free stack is filled with a pattern at
+ * start-up; the deepest use since then is the lowest word that no
+ * longer holds it. See intPriority.h for the budget.
+ */
+
+#ifndef STACKUSAGE_H_
+#define STACKUSAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fill the unused stack with the pattern. Call first thing in main(),
+// before any interrupt is enabled.
+void initStackUsage(void);
+
+// Deepest stack use since initStackUsage(), in bytes
+uint32_t getStackUsed(void);
+
+// Size of the stack in bytes
+uint32_t getStackSize(void);
+
+#endif /* STACKUSAGE_H_ */
@@ -0,0 +1,236 @@
+/*
+ * telemetry.c
+ *
+ * Binary telemetry frames: fixed little-endian layout, CRC-16, COBS
+ * framing, plus the channel registry. See telemetry.h for the layouts.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "telemetry.h"
+#include "uart.h"
+
+//**********************************************************************
+// Globals to module
+//**********************************************************************
+static uint8_t g_mode = TELEMETRY_TEXT;
+static uint16_t g_sequence;
+static volatile uint8_t g_divider = TELEMETRY_TICK_HZ / TELEMETRY_DEFAULT_HZ;
+
+// Channel registry
+static const uint8_t g_channelWidth[NUM_TELEMETRY_CHANNELS] = {
+    2, 2, 2, 2, 2, 2,   // Altitude, yaw, duties
+    1,                  // Mode
+    2, 2, 2, 2, 2, 2,   // PID terms
+    4                   // Loop cycles
+};
+static int32_t g_channelValue[NUM_TELEMETRY_CHANNELS];
+static uint8_t g_channelDecimation[NUM_TELEMETRY_CHANNELS];   // 0 = off
+static uint8_t g_channelCount[NUM_TELEMETRY_CHANNELS];        // Frames until due
+
+// Set the binary frame rate in Hz
+bool setTelemetryRate(uint16_t hz)
+{
+    if (hz == 0 || hz > TELEMETRY_TICK_HZ || TELEMETRY_TICK_HZ % hz != 0) {
+        return false;
+    }
+
+    g_divider = TELEMETRY_TICK_HZ / hz;
+    return true;
+}
+
+// Control ticks per binary frame
+uint8_t getTelemetryDivider(void)
+{
+    return g_divider;
+}
+
+// Subscribe to a channel, or unsubscribe with a decimation of 0
+bool telemetrySubscribe(uint8_t channel, uint8_t decimation)
+{
+    if (channel >= NUM_TELEMETRY_CHANNELS) {
+        return false;
+    }
+
+    g_channelDecimation[channel] = decimation;
+    g_channelCount[channel] = 0;        // Due in the next frame
+    return true;
+}
+
+// Record the latest value of a channel
+void telemetryPublish(uint8_t channel, int32_t value)
+{
+    if (channel < NUM_TELEMETRY_CHANNELS) {
+        g_channelValue[channel] = value;
+    }
+}
+
+// Select text or binary frames
+void setTelemetryMode(uint8_t mode)
+{
+    g_mode = mode;
+}
+
+uint8_t getTelemetryMode(void)
+{
+    return g_mode;
+}
+
+//**********************************************************************
+// CRC-16/CCITT-FALSE, bitwise. Frames are short, so the 512 byte table
+// isn't worth the flash.
+//**********************************************************************
+uint16_t crc16Ccitt(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+    uint8_t bit;
+
+    while (len--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+//**********************************************************************
+// COBS encode: every zero in the input is replaced by the distance to
+// the next zero, so the only zero in the output is the delimiter.
+//**********************************************************************
+uint16_t cobsEncode(const uint8_t *in, uint16_t len, uint8_t *out)
+{
+    uint16_t code_idx = 0;      // Where the current block's code byte goes
+    uint16_t out_idx = 1;
+    uint8_t code = 1;           // Distance to the next zero
+
+    while (len--) {
+        if (*in) {
+            out[out_idx++] = *in;
+            code++;
+        }
+        if (!*in || code == 0xFF) {
+            out[code_idx] = code;
+            code_idx = out_idx++;
+            code = 1;
+        }
+        in++;
+    }
+
+    out[code_idx] = code;
+    out[out_idx++] = 0;
+
+    return out_idx;
+}
+
+// Little-endian field writers
+uint8_t *putU16(uint8_t *p, uint16_t v)
+{
+    *p++ = v;
+    *p++ = v >> 8;
+    return p;
+}
+
+uint8_t *putU32(uint8_t *p, uint32_t v)
+{
+    p = putU16(p, v);
+    return putU16(p, v >> 16);
+}
+
+// CRC, encode and queue a built frame
+bool telemetrySubmit(uint8_t *frame, uint16_t len, uint16_t size)
+{
+    uint8_t *encoded;
+
+    if (len + TELEMETRY_CRC_LEN > size
+        || COBS_MAX_LEN(len + TELEMETRY_CRC_LEN) > UART_DMA_BUF_SIZE) {
+        return false;
+    }
+
+    // Both buffers still on the wire -- drop this frame
+    encoded = uartDmaAcquire();
+    if (!encoded) {
+        return false;
+    }
+
+    putU16(frame + len, crc16Ccitt(frame, len));
+    len = cobsEncode(frame, len + TELEMETRY_CRC_LEN, encoded);
+    uartDmaSubmit(encoded, len);
+
+    return true;
+}
+
+// Build, encode and queue one flight data frame
+void sendTelemetryFrame(uint32_t timestamp, uint16_t main_duty,
+    uint16_t tail_duty, int16_t altitude, int16_t desired_alt, int16_t yaw,
+    int16_t desired_yaw, uint8_t mode)
+{
+    uint8_t frame[TELEMETRY_FRAME_LEN];
+    uint8_t *p = frame;
+
+    *p++ = TELEMETRY_TYPE_FLIGHT;
+    p = putU16(p, g_sequence++);
+    p = putU32(p, timestamp);
+    p = putU16(p, altitude);
+    p = putU16(p, desired_alt);
+    p = putU16(p, yaw);
+    p = putU16(p, desired_yaw);
+    p = putU16(p, main_duty);
+    p = putU16(p, tail_duty);
+    *p++ = mode;
+
+    // A dropped frame still uses its sequence number, so the host can
+    // see the gap
+    telemetrySubmit(frame, p - frame, sizeof(frame));
+}
+
+// Build, encode and queue one channel frame
+void sendTelemetryChannels(uint32_t timestamp)
+{
+    uint8_t frame[TELEMETRY_CHANNELS_MAX_LEN];
+    uint8_t *p;
+    uint16_t mask = 0;
+    uint8_t ch;
+
+    // Work out which channels are due this frame
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        if (g_channelDecimation[ch] == 0) {
+            continue;
+        }
+        if (g_channelCount[ch] == 0) {
+            mask |= 1 << ch;
+            g_channelCount[ch] = g_channelDecimation[ch];
+        }
+        g_channelCount[ch]--;
+    }
+
+    if (!mask) {
+        return;
+    }
+
+    frame[0] = TELEMETRY_TYPE_CHANNELS;
+    p = putU16(frame + 1, g_sequence++);
+    p = putU32(p, timestamp);
+    p = putU16(p, mask);
+
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        if (!(mask & (1 << ch))) {
+            continue;
+        }
+        switch (g_channelWidth[ch]) {
+            case 1:
+                *p++ = g_channelValue[ch];
+                break;
+            case 2:
+                p = putU16(p, g_channelValue[ch]);
+                break;
+            default:
+                p = putU32(p, g_channelValue[ch]);
+                break;
+        }
+    }
+
+    telemetrySubmit(frame, p - frame, sizeof(frame));
+}
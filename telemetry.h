@@ -0,0 +1,128 @@
+/*
+ * telemetry.h
+ *
+ * Binary telemetry over UART. Each frame is a fixed little-endian
+ * record with a sequence number, SysTick timestamp and CRC-16, COBS
+ * encoded and terminated by a zero byte, so a receiver can always
+ * resynchronise on the next zero. tools/telemetry_decode.py turns a
+ * captured stream back into CSV.
+ *
+ * Frame layout before encoding (TELEMETRY_FRAME_LEN bytes):
+ *   0  uint8   frame type (TELEMETRY_TYPE_FLIGHT)
+ *   1  uint16  sequence number
+ *   3  uint32  timestamp, SysTick counts
+ *   7  int16   altitude, %
+ *   9  int16   desired altitude, %
+ *  11  int16   yaw, degrees
+ *  13  int16   desired yaw, degrees
+ *  15  uint16  main duty, %
+ *  17  uint16  tail duty, %
+ *  19  uint8   mode
+ *  20  uint16  CRC-16/CCITT-FALSE of bytes 0-19
+ *
+ * Channel frames carry only the channels the host has subscribed to,
+ * each at its own decimation of the frame rate:
+ *   0  uint8   frame type (TELEMETRY_TYPE_CHANNELS)
+ *   1  uint16  sequence number
+ *   3  uint32  timestamp, SysTick counts
+ *   7  uint16  bit mask of the channels present
+ *   9  ...     values of the present channels in ID order, each the
+ *              width given for it in enum telemetryChannels
+ *   n  uint16  CRC-16/CCITT-FALSE of bytes 0 to n-1
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TELEMETRY_TYPE_FLIGHT   0x01
+#define TELEMETRY_TYPE_CHANNELS 0x02
+#define TELEMETRY_TYPE_REC_INFO 0x03    // Flight recorder dump, see recorder.h
+#define TELEMETRY_TYPE_REC_DATA 0x04
+#define TELEMETRY_TYPE_LOG_INFO 0x05    // Flash log dump, see flashLog.h
+#define TELEMETRY_TYPE_LOG_DATA 0x06
+#define TELEMETRY_FRAME_LEN     22
+#define TELEMETRY_CHANNELS_MAX_LEN  40  // Every channel subscribed
+
+#define TELEMETRY_CRC_LEN       2       // CRC appended by telemetrySubmit()
+
+// Worst-case COBS output for n bytes, plus the zero delimiter
+#define COBS_MAX_LEN(n)         ((n) + (n) / 254 + 2)
+
+// Rate of the control tick that paces telemetry; matches SYSTICK_RATE_HZ
+#define TELEMETRY_TICK_HZ       100
+#define TELEMETRY_DEFAULT_HZ    25      // Fits 9600 baud
+
+enum telemetryModes {TELEMETRY_TEXT = 0, TELEMETRY_BINARY, TELEMETRY_CHANNELS};
+
+// Channel IDs. Values are int16 unless noted. PID terms are in
+// hundredths of a duty cycle percent.
+enum telemetryChannels {
+    TCH_ALT = 0,            // %
+    TCH_DESIRED_ALT,        // %
+    TCH_YAW,                // degrees
+    TCH_DESIRED_YAW,        // degrees
+    TCH_MAIN_DUTY,          // %
+    TCH_TAIL_DUTY,          // %
+    TCH_MODE,               // uint8
+    TCH_ALT_P,
+    TCH_ALT_I,
+    TCH_ALT_D,
+    TCH_YAW_P,
+    TCH_YAW_I,
+    TCH_YAW_D,
+    TCH_LOOP_CYCLES,        // uint32, CPU cycles per main loop pass
+    NUM_TELEMETRY_CHANNELS
+};
+
+// Set the binary frame rate in Hz. It must divide TELEMETRY_TICK_HZ;
+// returns false otherwise.
+bool setTelemetryRate(uint16_t hz);
+
+// Control ticks per binary frame
+uint8_t getTelemetryDivider(void);
+
+// Subscribe to a channel, sent in every decimation'th frame. A
+// decimation of 0 unsubscribes. Returns false for an unknown channel.
+bool telemetrySubscribe(uint8_t channel, uint8_t decimation);
+
+// Record the latest value of a channel
+void telemetryPublish(uint8_t channel, int32_t value);
+
+// Select text (formatUARTOutput), fixed binary or channel frames
+void setTelemetryMode(uint8_t mode);
+
+uint8_t getTelemetryMode(void);
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+uint16_t crc16Ccitt(const uint8_t *data, uint16_t len);
+
+// COBS encode len bytes from in to out and append the zero delimiter.
+// out must hold COBS_MAX_LEN(len) bytes. Returns the bytes written.
+uint16_t cobsEncode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+// Append the CRC to a built frame of len bytes, COBS encode it and
+// queue it. size is the capacity of the frame buffer, which must have
+// TELEMETRY_CRC_LEN spare bytes after the frame for the CRC. Returns
+// false, dropping the frame, if both buffers are busy, or if the CRC
+// doesn't fit or the encoded frame wouldn't fit a UART DMA buffer.
+bool telemetrySubmit(uint8_t *frame, uint16_t len, uint16_t size);
+
+// Little-endian field writers for building frames. Each returns the
+// byte after the field.
+uint8_t *putU16(uint8_t *p, uint16_t v);
+
+uint8_t *putU32(uint8_t *p, uint32_t v);
+
+// Build, encode and queue one flight data frame
+void sendTelemetryFrame(uint32_t timestamp, uint16_t main_duty,
+    uint16_t tail_duty, int16_t altitude, int16_t desired_alt, int16_t yaw,
+    int16_t desired_yaw, uint8_t mode);
+
+// Build, encode and queue one channel frame from the published values.
+// Nothing is sent if no channel is due.
+void sendTelemetryChannels(uint32_t timestamp);
+
+#endif /* TELEMETRY_H_ */
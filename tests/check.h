@@ -0,0 +1,44 @@
+/*
+ * check.h
+ *
+ * Minimal assertions for the host tests. A failed check prints where
+ * it was and what it saw, and the test carries on; main() returns
+ * checkResult() so make stops on any failure.
+ */
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+static int g_checkFailures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,     \
+                   #cond);                                              \
+            g_checkFailures++;                                          \
+        }                                                               \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                      \
+    do {                                                                \
+        long long a_ = (long long)(actual);                             \
+        long long e_ = (long long)(expected);                           \
+        if (a_ != e_) {                                                 \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__,      \
+                   __LINE__, #actual, a_, e_);                          \
+            g_checkFailures++;                                          \
+        }                                                               \
+    } while (0)
+
+// Print a summary line and return the exit status for main()
+static int
+checkResult(const char *name)
+{
+    printf("%s: %s\n", name, g_checkFailures ? "FAILED" : "ok");
+    return g_checkFailures != 0;
+}
+
+#endif /* CHECK_H_ */
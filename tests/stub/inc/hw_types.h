@@ -0,0 +1,15 @@
+/*
+ * hw_types.h
+ *
+ * Host stand-in for TivaWare's inc/hw_types.h, enough for headers that
+ * define register access in inline functions the tests never call.
+ */
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+
+#define HWREG(x)                (*((volatile uint32_t *)(uintptr_t)(x)))
+
+#endif /* __HW_TYPES_H__ */
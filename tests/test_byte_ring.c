@@ -0,0 +1,167 @@
+/*
+ * test_byte_ring.c
+ *
+ * Host test for byteRing.h, the UART transmit and receive ring:
+ * empty and full states, partial writes into a nearly full ring,
+ * wrap of the storage and of the 16-bit head/tail counts, and data
+ * coming out in the order it went in.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "check.h"
+#include "byteRing.h"
+
+#define RING_SIZE               8
+
+static void
+testEmpty(void)
+{
+    char buf[RING_SIZE];
+    byteRing_t ring = BYTE_RING(buf);
+    char out[RING_SIZE];
+    char c = 'x';
+
+    CHECK(byteRingEmpty(&ring));
+    CHECK(!byteRingFull(&ring));
+    CHECK_EQ(byteRingCount(&ring), 0);
+    CHECK(!byteRingGet(&ring, &c));
+    CHECK_EQ(c, 'x');
+    CHECK_EQ(byteRingRead(&ring, out, sizeof(out)), 0);
+}
+
+static void
+testFull(void)
+{
+    char buf[RING_SIZE];
+    byteRing_t ring;
+    char out[RING_SIZE];
+    uint16_t i;
+
+    byteRingInit(&ring, buf, RING_SIZE);
+
+    // Every slot is usable; the next byte is refused
+    for (i = 0; i < RING_SIZE; i++) {
+        CHECK(byteRingPut(&ring, 'a' + i));
+    }
+    CHECK(byteRingFull(&ring));
+    CHECK_EQ(byteRingCount(&ring), RING_SIZE);
+    CHECK(!byteRingPut(&ring, 'z'));
+    CHECK_EQ(byteRingWrite(&ring, "zz", 2), 0);
+    CHECK_EQ(byteRingCount(&ring), RING_SIZE);
+
+    // The refused bytes didn't overwrite anything
+    CHECK_EQ(byteRingRead(&ring, out, sizeof(out)), RING_SIZE);
+    for (i = 0; i < RING_SIZE; i++) {
+        CHECK_EQ(out[i], 'a' + i);
+    }
+    CHECK(byteRingEmpty(&ring));
+}
+
+static void
+testPartialWrite(void)
+{
+    char buf[RING_SIZE];
+    byteRing_t ring = BYTE_RING(buf);
+    char out[RING_SIZE];
+
+    CHECK_EQ(byteRingWrite(&ring, "012345", 6), 6);
+    CHECK_EQ(byteRingWrite(&ring, "6789", 4), 2);
+    CHECK(byteRingFull(&ring));
+
+    // A short read leaves the rest in order
+    CHECK_EQ(byteRingRead(&ring, out, 3), 3);
+    CHECK_EQ(out[0], '0');
+    CHECK_EQ(out[2], '2');
+    CHECK_EQ(byteRingCount(&ring), RING_SIZE - 3);
+
+    CHECK_EQ(byteRingRead(&ring, out, sizeof(out)), RING_SIZE - 3);
+    CHECK_EQ(out[0], '3');
+    CHECK_EQ(out[4], '7');
+}
+
+// Run far enough for head and tail to wrap past 65535 several times,
+// with the fill level moving about, and check every byte comes back in
+// order
+static void
+testWrap(void)
+{
+    char buf[RING_SIZE];
+    byteRing_t ring = BYTE_RING(buf);
+    uint8_t next = 0;           // Next byte to write
+    uint8_t expect = 0;         // Next byte to read
+    uint32_t total = 0;         // Bytes through the ring
+    uint32_t step;
+
+    for (step = 0; step < 300000; step++) {
+        uint16_t n = (step * 7) % (RING_SIZE + 3);
+        uint16_t free = RING_SIZE - byteRingCount(&ring);
+        char chunk[RING_SIZE + 3];
+        uint16_t i;
+        uint16_t got;
+
+        for (i = 0; i < n; i++) {
+            chunk[i] = (char)(next + i);
+        }
+        got = byteRingWrite(&ring, chunk, n);
+        CHECK_EQ(got, n < free ? n : free);
+        next += got;
+        total += got;
+
+        n = (step * 5) % (RING_SIZE + 2);
+        for (i = 0; i < n; i++) {
+            char c;
+
+            if (!byteRingGet(&ring, &c)) {
+                CHECK_EQ(expect, next);
+                break;
+            }
+            CHECK_EQ((uint8_t)c, expect);
+            expect++;
+        }
+
+        CHECK(byteRingCount(&ring) <= RING_SIZE);
+        CHECK_EQ(byteRingCount(&ring), (uint8_t)(next - expect));
+    }
+
+    // Head and tail wrapped several times
+    CHECK(total > 4 * 65536u);
+}
+
+// A 32768-byte ring, the largest allowed, fills and empties exactly
+static void
+testLargest(void)
+{
+    static char buf[32768];
+    byteRing_t ring = BYTE_RING(buf);
+    uint32_t i;
+    char c;
+
+    for (i = 0; i < sizeof(buf); i++) {
+        CHECK(byteRingPut(&ring, (char)i));
+    }
+    CHECK(byteRingFull(&ring));
+    CHECK(!byteRingPut(&ring, 0));
+
+    for (i = 0; i < sizeof(buf); i++) {
+        CHECK(byteRingGet(&ring, &c));
+    }
+    CHECK(byteRingEmpty(&ring));
+}
+
+int
+main(void)
+{
+    testEmpty();
+    testFull();
+    testPartialWrite();
+    testWrap();
+    testLargest();
+
+    return checkResult("test_byte_ring");
+}
+
+#endif /* HOST_TEST */
@@ -0,0 +1,396 @@
+/*
+ * test_command_fuzz.c
+ *
+ * Host fuzz driver for command.c. Random lines, random bytes and
+ * over-long lines are fed through commandPoll() in random chunk sizes,
+ * with the UART, control, telemetry and logging calls replaced by
+ * fakes below. Checks that:
+ *
+ *   - every reply is one whole line that fits the reply buffer
+ *   - a line longer than COMMAND_LINE_MAX is discarded, not truncated
+ *     and acted on
+ *   - no line gets more than one reply, so the work per received byte
+ *     is bounded; the run's average time per byte is also checked
+ *   - a refusal echoes only the first word of the line
+ *   - ALT and YAW are refused on the ground, and a target queued in
+ *     flight is dropped when flying stops
+ *
+ * A crash or sanitizer report fails the run; build with
+ * make -C tests clean all CFLAGS_EXTRA=-fsanitize=address,undefined to check
+ * for out-of-bounds access as well.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "check.h"
+#include "command.h"
+#include "uart.h"
+#include "control.h"
+#include "telemetry.h"
+#include "yawDetection.h"
+#include "recorder.h"
+#include "flashLog.h"
+#include "display.h"
+#include "isrTiming.h"
+
+// Must match command.c
+#define COMMAND_LINE_MAX        32
+
+#define FUZZ_LINES              200000
+#define FUZZ_MAX_NS_PER_BYTE    20000
+
+//**********************************************************************
+// Fake UART: input comes from g_in, replies are checked and counted
+//**********************************************************************
+static const char *g_in;
+static uint16_t g_inLen;
+static uint32_t g_replies;
+static uint32_t g_badReplies;
+static char g_lastReply[64];
+static uint32_t g_baud = 9600;
+
+uint16_t uartRead(char *pcData, uint16_t ui16Max)
+{
+    uint16_t count = 1 + rand() % ui16Max;
+
+    if (count > g_inLen) {
+        count = g_inLen;
+    }
+    memcpy(pcData, g_in, count);
+    g_in += count;
+    g_inLen -= count;
+    return count;
+}
+
+void UARTSend(char *pucBuffer)
+{
+    size_t len = strlen(pucBuffer);
+
+    // One whole line, no longer than the reply buffer allows
+    if (len < 3 || len >= COMMAND_LINE_MAX + 8
+        || strcmp(pucBuffer + len - 2, "\r\n") != 0
+        || memchr(pucBuffer, '\n', len - 1) != 0) {
+        g_badReplies++;
+    }
+
+    if (len < sizeof(g_lastReply)) {
+        strcpy(g_lastReply, pucBuffer);
+    }
+    g_replies++;
+}
+
+void uartPoll(void)
+{
+}
+
+bool uartSetBaud(uint32_t ui32Baud)
+{
+    if (ui32Baud != 9600 && ui32Baud != 115200) {
+        return false;
+    }
+    g_baud = ui32Baud;
+    return true;
+}
+
+uint32_t uartGetBaud(void)
+{
+    return g_baud;
+}
+
+//**********************************************************************
+// Fakes for the rest of the firmware command.c calls into
+//**********************************************************************
+static float g_gains[6];
+
+void setAltGains(float Kp, float Ki, float Kd)
+{
+    g_gains[0] = Kp; g_gains[1] = Ki; g_gains[2] = Kd;
+}
+
+void setYawGains(float Kp, float Ki, float Kd)
+{
+    g_gains[3] = Kp; g_gains[4] = Ki; g_gains[5] = Kd;
+}
+
+void getAltGains(float *Kp, float *Ki, float *Kd)
+{
+    *Kp = g_gains[0]; *Ki = g_gains[1]; *Kd = g_gains[2];
+}
+
+void getYawGains(float *Kp, float *Ki, float *Kd)
+{
+    *Kp = g_gains[3]; *Ki = g_gains[4]; *Kd = g_gains[5];
+}
+
+bool setTelemetryRate(uint16_t hz) { return hz != 0 && 100 % hz == 0; }
+bool telemetrySubscribe(uint8_t channel, uint8_t decimation)
+{
+    (void)decimation;
+    return channel < 16;
+}
+void setTelemetryMode(uint8_t mode) { (void)mode; }
+
+static uint8_t g_recCause;
+void recorderFreeze(uint8_t cause) { g_recCause = cause; }
+uint8_t getRecorderCause(void) { return g_recCause; }
+void recorderClear(void) { g_recCause = 0; }
+void recorderStartDump(void) { }
+
+void flashLogStartDump(void) { }
+void flashLogClear(void) { }
+uint32_t flashLogDropped(void) { return 0; }
+
+uint32_t benchDisplayUpdate(void) { return 1234567; }
+uint32_t benchDisplayText(void) { return 321; }
+uint32_t benchDisplayFormat(bool fast) { return fast ? 150 : 900; }
+uint32_t benchYawGPIO(bool fast) { return fast ? 5 : 40; }
+int32_t getYawRefDrift(void) { return -3; }
+int32_t getYawRefDriftMax(void) { return 7; }
+uint32_t getISRMaxRunCycles(uint8_t id) { return 1000 + id; }
+uint32_t getSysTickMaxLatency(void) { return 12; }
+uint32_t getLoopMaxCycles(void) { return 2147483647; }
+uint32_t getPWMStartSkew(void) { return 9; }
+uint32_t getStackUsed(void) { return 700; }
+uint32_t uartRxDropped(void) { return 11; }
+uint32_t uartTxDropped(void) { return 22; }
+uint32_t uartDmaDropped(void) { return 33; }
+uint32_t benchRotorUpdate(bool cached) { return cached ? 60 : 210; }
+
+//**********************************************************************
+// Driver
+//**********************************************************************
+static uint32_t g_ticks;
+
+// Feed bytes through commandPoll() and return the number of replies
+static uint32_t
+feed(const char *data, uint16_t len)
+{
+    uint32_t before = g_replies;
+
+    g_in = data;
+    g_inLen = len;
+    while (g_inLen > 0) {
+        commandPoll(g_ticks++);
+    }
+    return g_replies - before;
+}
+
+static uint32_t
+feedLine(const char *line)
+{
+    g_lastReply[0] = '\0';
+    return feed(line, strlen(line));
+}
+
+// Known lines at the edges of the line buffer
+static void
+testEdges(void)
+{
+    char line[COMMAND_LINE_MAX + 8];
+
+    setCommandFlying(true);
+
+    // Exactly COMMAND_LINE_MAX characters is a line, and is refused by
+    // its first word alone
+    memset(line, 'x', COMMAND_LINE_MAX);
+    memcpy(line, "FOO ", 4);
+    strcpy(line + COMMAND_LINE_MAX, "\n");
+    CHECK_EQ(feedLine(line), 1);
+    CHECK(strcmp(g_lastReply, "NAK FOO\r\n") == 0);
+
+    // One more character and the whole line is discarded
+    memset(line, 'x', COMMAND_LINE_MAX + 1);
+    strcpy(line + COMMAND_LINE_MAX + 1, "\n");
+    CHECK_EQ(feedLine(line), 0);
+
+    // An over-long line that starts with a valid command isn't acted on
+    memset(line, ' ', COMMAND_LINE_MAX + 4);
+    memcpy(line, "MODE LAND", 9);
+    strcpy(line + COMMAND_LINE_MAX + 4, "\r");
+    CHECK_EQ(feedLine(line), 0);
+
+    // and the next line is read cleanly
+    CHECK_EQ(feedLine("ALT 50\r\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK ALT 50\r\n") == 0);
+
+    // A single word of the maximum length echoes whole
+    memset(line, 'Q', COMMAND_LINE_MAX);
+    strcpy(line + COMMAND_LINE_MAX, "\r");
+    CHECK_EQ(feedLine(line), 1);
+    CHECK_EQ(strlen(g_lastReply), 4 + COMMAND_LINE_MAX + 2);
+
+    // Refusals of known commands name only the command
+    CHECK_EQ(feedLine("GAIN ALT Z 12 and more\n"), 1);
+    CHECK(strcmp(g_lastReply, "NAK GAIN\r\n") == 0);
+
+    // The widest reply value fits
+    CHECK_EQ(feedLine("TIME LOOP\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK TIME 2147483647\r\n") == 0);
+
+    CHECK_EQ(feedLine("UART RX\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK UART 11\r\n") == 0);
+    CHECK_EQ(feedLine("UART TX\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK UART 22\r\n") == 0);
+    CHECK_EQ(feedLine("UART DMA\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK UART 33\r\n") == 0);
+
+    // Signed replies
+    CHECK_EQ(feedLine("REF DRIFT\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK REF -3\r\n") == 0);
+    CHECK_EQ(feedLine("REF DRIFT MAX\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK REF 7\r\n") == 0);
+}
+
+// ALT and YAW only while flying
+static void
+testFlying(void)
+{
+    int32_t value;
+
+    setCommandFlying(false);
+    CHECK_EQ(feedLine("ALT 100\n"), 1);
+    CHECK(strcmp(g_lastReply, "NAK ALT\r\n") == 0);
+    CHECK_EQ(feedLine("YAW 90\n"), 1);
+    CHECK(strcmp(g_lastReply, "NAK YAW\r\n") == 0);
+    CHECK(!checkCommand(CMD_ALT, &value));
+    CHECK(!checkCommand(CMD_YAW, &value));
+
+    // MODE is still taken on the ground
+    CHECK_EQ(feedLine("MODE FLY\n"), 1);
+    CHECK(checkCommand(CMD_MODE, &value));
+    CHECK_EQ(value, CMD_MODE_FLY);
+
+    // Accepted in flight, then dropped unread on landing
+    setCommandFlying(true);
+    CHECK_EQ(feedLine("ALT 100\n"), 1);
+    CHECK(strcmp(g_lastReply, "ACK ALT 100\r\n") == 0);
+    CHECK_EQ(feedLine("YAW 90\n"), 1);
+    setCommandFlying(false);
+    setCommandFlying(true);
+    CHECK(!checkCommand(CMD_ALT, &value));
+    CHECK(!checkCommand(CMD_YAW, &value));
+
+    // and read once when still flying
+    CHECK_EQ(feedLine("ALT 30\n"), 1);
+    CHECK(checkCommand(CMD_ALT, &value));
+    CHECK_EQ(value, 30);
+    CHECK(!checkCommand(CMD_ALT, &value));
+}
+
+static const char *const g_words[] = {
+    "BAUD", "OK", "ALT", "YAW", "GAIN", "RATE", "TEL", "TEXT", "BIN", "CH",
+    "REC", "FREEZE", "DUMP", "CLEAR", "LOG", "TIME", "RUN", "LATENCY",
+    "LOOP", "PWM", "BENCH", "GPIO", "LIB", "OLED", "FMT", "WRITE", "SUB", "MODE", "FLY",
+    "LAND", "STACK", "REF", "UART", "RX", "TX", "DMA", "DRIFT", "MAX",
+    "P", "I", "D", "9600", "115200", "0", "-1", "100", "2147483648",
+    "-2147483649", "99999999999", "4", "",
+};
+
+#define NUM_WORDS               (sizeof(g_words) / sizeof(g_words[0]))
+
+// Build a random line: command words, random bytes, or a mix, ending
+// in CR, LF or both. Returns its length.
+static uint16_t
+randomLine(char *line, uint16_t max)
+{
+    uint16_t len = 0;
+    uint16_t target = rand() % (rand() % 4 == 0 ? max - 2 : COMMAND_LINE_MAX + 4);
+    int kind = rand() % 3;
+
+    while (len < target) {
+        if (kind == 0 || (kind == 2 && rand() % 2)) {
+            const char *word = g_words[rand() % NUM_WORDS];
+
+            while (*word != '\0' && len < target) {
+                line[len++] = *word++;
+            }
+            if (len < target) {
+                line[len++] = ' ';
+            }
+        }
+        else {
+            char c = rand() % 256;
+
+            // Keep terminators for the end of the line
+            line[len++] = (c == '\r' || c == '\n') ? ' ' : c;
+        }
+    }
+
+    switch (rand() % 3) {
+        case 0: line[len++] = '\r'; break;
+        case 1: line[len++] = '\n'; break;
+        default: line[len++] = '\r'; line[len++] = '\n'; break;
+    }
+    return len;
+}
+
+static void
+testFuzz(void)
+{
+    char line[256];
+    uint32_t lines;
+    uint32_t bytes = 0;
+    uint32_t extraReplies = 0;
+    uint32_t longReplied = 0;
+    clock_t start;
+    double nsPerByte;
+    int32_t value;
+    uint8_t cmd;
+
+    srand(41);
+    start = clock();
+
+    for (lines = 0; lines < FUZZ_LINES; lines++) {
+        uint16_t len = randomLine(line, sizeof(line));
+        uint16_t content = len;
+        uint32_t replies;
+
+        setCommandFlying(rand() % 2);
+        while (content > 0 && (line[content - 1] == '\r' || line[content - 1] == '\n')) {
+            content--;
+        }
+
+        replies = feed(line, len);
+        bytes += len;
+
+        // One reply at most per line, none for a discarded one
+        if (replies > 1) {
+            extraReplies++;
+        }
+        if (content > COMMAND_LINE_MAX && replies != 0) {
+            longReplied++;
+        }
+
+        for (cmd = 0; cmd < NUM_CMDS; cmd++) {
+            checkCommand(cmd, &value);
+        }
+    }
+
+    nsPerByte = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / bytes;
+    printf("test_command_fuzz: %u lines, %u bytes, %.0f ns per byte\n",
+           (unsigned)lines, (unsigned)bytes, nsPerByte);
+
+    CHECK_EQ(g_badReplies, 0);
+    CHECK_EQ(extraReplies, 0);
+    CHECK_EQ(longReplied, 0);
+    CHECK(g_replies > FUZZ_LINES / 4);
+    CHECK(nsPerByte < FUZZ_MAX_NS_PER_BYTE);
+}
+
+int
+main(void)
+{
+    testEdges();
+    testFlying();
+    testFuzz();
+
+    return checkResult("test_command_fuzz");
+}
+
+#endif /* HOST_TEST */
@@ -0,0 +1,107 @@
+/*
+ * test_fastgpio.c
+ *
+ * Host test for fastGPIO.h against the simulated register file in
+ * fastGPIOSim.c: every pin mask reads back exactly the masked levels,
+ * as GPIOPinRead() would, and the interrupt clear touches only the
+ * pins it names.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "check.h"
+#include "fastGPIO.h"
+
+// Port base addresses from inc/hw_memmap.h
+#define PORTB_BASE              0x40005000
+#define PORTC_BASE              0x40006000
+#define PORTE_BASE              0x40024000
+
+// Every level pattern under every pin mask
+static void
+testReadMasks(void)
+{
+    uint32_t levels;
+    uint32_t pins;
+
+    for (levels = 0; levels < 0x100; levels++) {
+        fastGPIOSimSetPins(PORTB_BASE, levels);
+        for (pins = 0; pins < 0x100; pins++) {
+            CHECK_EQ(fastGPIORead(PORTB_BASE, pins), levels & pins);
+        }
+    }
+}
+
+// The two encoder pins read together, as handleYaw() does
+static void
+testEncoderPins(void)
+{
+    fastGPIOSimSetPins(PORTB_BASE, 0xFC);
+    CHECK_EQ(fastGPIORead(PORTB_BASE, 0x03), 0x00);
+
+    fastGPIOSimSetPins(PORTB_BASE, 0x02);
+    CHECK_EQ(fastGPIORead(PORTB_BASE, 0x03), 0x02);
+
+    fastGPIOSimSetPins(PORTB_BASE, 0x03);
+    CHECK_EQ(fastGPIORead(PORTB_BASE, 0x01), 0x01);
+    CHECK_EQ(fastGPIORead(PORTB_BASE, 0x02), 0x02);
+}
+
+// Ports don't share state
+static void
+testPortsIndependent(void)
+{
+    fastGPIOSimSetPins(PORTB_BASE, 0x00);
+    fastGPIOSimSetPins(PORTC_BASE, 0x10);
+    fastGPIOSimSetPins(PORTE_BASE, 0xFF);
+
+    CHECK_EQ(fastGPIORead(PORTB_BASE, 0xFF), 0x00);
+    CHECK_EQ(fastGPIORead(PORTC_BASE, 0xFF), 0x10);
+    CHECK_EQ(fastGPIORead(PORTE_BASE, 0xFF), 0xFF);
+}
+
+static void
+testIntClear(void)
+{
+    uint32_t pins;
+
+    // Clearing some pins leaves the rest pending
+    fastGPIOSimSetPins(PORTB_BASE, 0x00);
+    fastGPIOIntClear(PORTB_BASE, 0xFF);
+    fastGPIOSimSetPins(PORTB_BASE, 0x03);
+    CHECK_EQ(fastGPIOSimPending(PORTB_BASE), 0x03);
+
+    fastGPIOIntClear(PORTB_BASE, 0x01);
+    CHECK_EQ(fastGPIOSimPending(PORTB_BASE), 0x02);
+
+    fastGPIOIntClear(PORTB_BASE, 0x02);
+    CHECK_EQ(fastGPIOSimPending(PORTB_BASE), 0x00);
+
+    // Every clear mask against all flags set
+    for (pins = 0; pins < 0x100; pins++) {
+        fastGPIOSimSetPins(PORTC_BASE, 0x00);
+        fastGPIOIntClear(PORTC_BASE, 0xFF);
+        fastGPIOSimSetPins(PORTC_BASE, 0xFF);
+        fastGPIOIntClear(PORTC_BASE, pins);
+        CHECK_EQ(fastGPIOSimPending(PORTC_BASE), 0xFF & ~pins);
+    }
+
+    // Another port's flags are untouched
+    CHECK_EQ(fastGPIOSimPending(PORTE_BASE), 0xFF);
+}
+
+int
+main(void)
+{
+    testReadMasks();
+    testEncoderPins();
+    testPortsIndependent();
+    testIntClear();
+
+    return checkResult("test_fastgpio");
+}
+
+#endif /* HOST_TEST */
@@ -0,0 +1,303 @@
+/*
+ * test_flash_log.c
+ *
+ * Host test for the flash flight log (flashLog.c) on the file-backed
+ * flash simulator (flashDevSim.c). Fills the log past the end of the
+ * ring, erases ahead in idle time, and re-runs initFlashLog() as a
+ * reset: after a clean stop, after a reset part-way through
+ * programming a block, and with an erased run that stops mid-page.
+ * Checks the newest-block scan, the header-last partial-slot skip,
+ * the page realignment, wraparound, the erase-ahead budget, and the
+ * erase count of every page.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "check.h"
+#include "flashLog.h"
+#include "flashDev.h"
+#include "recorder.h"
+#include "telemetry.h"
+
+#define SLOT_SIZE               RECORDER_BLOCK_SIZE
+#define SLOT_WORDS              (SLOT_SIZE / 4)
+#define SLOTS                   (FLASH_LOG_SIZE / SLOT_SIZE)
+#define SLOTS_PER_PAGE          (FLASH_PAGE_SIZE / SLOT_SIZE)
+#define AHEAD_SLOTS             (FLASH_LOG_ERASE_AHEAD * SLOTS_PER_PAGE)
+#define IDLE_POLLS              (FLASH_LOG_PAGES * 2)
+
+// Erases each page should have had so far
+static uint32_t g_wear[FLASH_LOG_PAGES];
+
+//**********************************************************************
+// Fakes for telemetry.c
+//**********************************************************************
+uint8_t *putU16(uint8_t *p, uint16_t v)
+{
+    *p++ = v;
+    *p++ = v >> 8;
+    return p;
+}
+
+uint8_t *putU32(uint8_t *p, uint32_t v)
+{
+    p = putU16(p, v);
+    return putU16(p, v >> 16);
+}
+
+bool telemetrySubmit(uint8_t *frame, uint16_t len, uint16_t size)
+{
+    (void)frame;
+    (void)len;
+    (void)size;
+    return true;
+}
+
+//**********************************************************************
+// Helpers
+//**********************************************************************
+static uint32_t
+slotWord(uint16_t slot, uint8_t word)
+{
+    const uint8_t *p = flashDevRead(slot * SLOT_SIZE + word * 4);
+
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+// Body byte i of block n. Never 0xFF, so no body word reads as erased.
+static uint8_t
+bodyByte(uint32_t n, uint16_t i)
+{
+    return (n * 7 + i) & 0x7F;
+}
+
+static void
+makeBlock(uint8_t *block, uint32_t n)
+{
+    uint16_t i;
+
+    for (i = 0; i < SLOT_SIZE; i++) {
+        block[i] = bodyByte(n, i);
+    }
+}
+
+// True if slot holds block n under sequence number sequence
+static bool
+slotHolds(uint16_t slot, uint32_t n, uint32_t sequence)
+{
+    const uint8_t *p = flashDevRead(slot * SLOT_SIZE);
+    uint16_t i;
+
+    if (slotWord(slot, 0) != sequence) {
+        return false;
+    }
+
+    for (i = 4; i < SLOT_SIZE; i++) {
+        if (p[i] != bodyByte(n, i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool
+slotErased(uint16_t slot)
+{
+    uint8_t i;
+
+    for (i = 0; i < SLOT_WORDS; i++) {
+        if (slotWord(slot, i) != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Log block n in flight and run the poll until it is programmed
+static void
+flyBlock(uint32_t n)
+{
+    uint8_t block[SLOT_SIZE];
+    uint8_t i;
+
+    makeBlock(block, n);
+    flashLogPoll(false);
+    flashLogAppend(block);
+    for (i = 0; i <= SLOT_WORDS; i++) {
+        flashLogPoll(false);
+    }
+}
+
+// Log count blocks from n on, checking each lands in the next slot
+// with the next sequence number
+static void
+flyBlocks(uint32_t n, uint32_t count, uint16_t *slot, uint32_t *sequence)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++) {
+        flyBlock(n + i);
+        CHECK(slotHolds(*slot, n + i, *sequence));
+        *slot = (*slot + 1) % SLOTS;
+        (*sequence)++;
+    }
+}
+
+static void
+idle(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < IDLE_POLLS; i++) {
+        flashLogPoll(true);
+    }
+}
+
+// Expect pages first to first + count - 1 (mod the ring) erased once more
+static void
+expectErased(uint16_t first, uint16_t count)
+{
+    uint16_t i;
+
+    for (i = 0; i < count; i++) {
+        g_wear[(first + i) % FLASH_LOG_PAGES]++;
+    }
+}
+
+static void
+checkWear(void)
+{
+    uint16_t page;
+
+    for (page = 0; page < FLASH_LOG_PAGES; page++) {
+        CHECK_EQ(flashDevWear(page), g_wear[page]);
+    }
+}
+
+//**********************************************************************
+// Tests
+//**********************************************************************
+int
+main(void)
+{
+    uint16_t slot = 0;
+    uint32_t sequence = 1;
+    uint32_t dropped;
+    uint8_t block[SLOT_SIZE];
+    uint8_t i;
+
+    remove(FLASH_SIM_FILE);
+
+    // Blank flash: start at slot 0, nothing to erase
+    initFlashLog();
+    idle();
+    checkWear();
+
+    // Motors off: nothing is logged
+    makeBlock(block, 0);
+    flashLogAppend(block);
+    idle();
+    CHECK(slotErased(0));
+
+    // Fill most of the ring. No erase runs in flight.
+    flyBlocks(1, 200, &slot, &sequence);
+    checkWear();
+    CHECK_EQ(flashLogDropped(), 0);
+
+    // 56 slots left; idle erases the oldest 34 pages to get back to
+    // the erase-ahead budget, and no more
+    idle();
+    expectErased(0, (AHEAD_SLOTS - (SLOTS - 200)) / SLOTS_PER_PAGE);
+    checkWear();
+    CHECK(slotErased(0));
+    CHECK(slotHolds(136, 137, 137));
+
+    // Wrap round the end of the ring
+    flyBlocks(201, 100, &slot, &sequence);
+    CHECK_EQ(slot, 44);
+    checkWear();
+
+    // Reset: the newest block is found behind the older ones at the
+    // end of the ring, and logging carries on after it
+    initFlashLog();
+    flyBlocks(301, 1, &slot, &sequence);
+    CHECK(slotHolds(44, 301, 301));
+
+    // Reset part-way through a block: the body is written, the header
+    // isn't. The half-written slot is skipped, not overwritten.
+    makeBlock(block, 302);
+    flashLogPoll(false);
+    flashLogAppend(block);
+    for (i = 0; i < 10; i++) {
+        flashLogPoll(false);
+    }
+    CHECK_EQ(slotWord(45, 0), 0xFFFFFFFF);
+    CHECK(!slotErased(45));
+
+    initFlashLog();
+    slot = 46;
+    flyBlocks(303, 1, &slot, &sequence);
+    CHECK(slotHolds(46, 303, 302));
+    CHECK_EQ(slotWord(45, 0), 0xFFFFFFFF);
+    checkWear();
+
+    // A dirty word part-way into the erased run (slot 50, page 12).
+    // The run after the newest block then ends mid-page, so the log
+    // gives up slot 47 and starts again at the next page, with nothing
+    // erased until it is idle.
+    flashDevProgram(50 * SLOT_SIZE + 8, 0x12345678);
+    initFlashLog();
+    dropped = flashLogDropped();
+    flyBlock(304);
+    CHECK_EQ(flashLogDropped(), dropped + 1);
+    CHECK(slotErased(47));
+    CHECK(slotErased(48));
+    checkWear();
+
+    // Idle from page 12 on, until the full budget is erased
+    idle();
+    expectErased(12, FLASH_LOG_ERASE_AHEAD);
+    checkWear();
+    CHECK(slotErased(50));
+
+    // Exactly the budget fits before the next idle period; one more
+    // is dropped, leaving the old block in the next slot alone
+    dropped = flashLogDropped();
+    slot = 48;
+    flyBlocks(305, AHEAD_SLOTS, &slot, &sequence);
+    CHECK_EQ(slot, 240);
+    CHECK_EQ(flashLogDropped(), dropped);
+    flyBlock(305 + AHEAD_SLOTS);
+    CHECK_EQ(flashLogDropped(), dropped + 1);
+    CHECK(slotHolds(240, 241, 241));
+    checkWear();
+
+    // Reset with no erased slot after the newest block: erase-ahead
+    // wraps from page 60 round to page 43, then logging wraps too
+    initFlashLog();
+    idle();
+    expectErased(60, FLASH_LOG_ERASE_AHEAD);
+    checkWear();
+    flyBlocks(1000, AHEAD_SLOTS, &slot, &sequence);
+    CHECK_EQ(slot, 176);
+
+    // The newest block is now in slot 175, with older ones either side
+    initFlashLog();
+    idle();
+    expectErased(44, FLASH_LOG_ERASE_AHEAD);
+    checkWear();
+    flyBlocks(2000, 1, &slot, &sequence);
+    CHECK(slotHolds(176, 2000, sequence - 1));
+    CHECK_EQ(flashLogDropped(), 0);
+
+    return checkResult("test_flash_log");
+}
+
+#endif /* HOST_TEST */
@@ -0,0 +1,157 @@
+/*
+ * test_num_format.c
+ *
+ * Host test for numFormat.c against the C library's snprintf(): random
+ * values, widths and decimal places, the int32 extremes, and field
+ * padding in fmtFixed(), which shifts its output right in place. Each
+ * output is written into a guarded buffer to catch stray writes.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "numFormat.h"
+
+#define GUARD                   '#'
+#define FIELD_MAX               20
+#define REF_MAX                 300     // Room for any snprintf() width
+
+static char g_buf[FIELD_MAX + 8];
+
+static void
+guard(void)
+{
+    memset(g_buf, GUARD, sizeof(g_buf));
+}
+
+// The output matches, the returned pointer is at its NUL, and nothing
+// past the NUL was touched
+static bool
+matches(const char *end, const char *expected)
+{
+    size_t len = strlen(expected);
+    size_t i;
+
+    if (strcmp(g_buf, expected) != 0 || end != g_buf + len) {
+        printf("got \"%s\", expected \"%s\"\n", g_buf, expected);
+        return false;
+    }
+    for (i = len + 1; i < sizeof(g_buf); i++) {
+        if (g_buf[i] != GUARD) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// snprintf() reference for fmtFixed()
+static void
+fixedReference(char *out, int32_t value, uint8_t places, uint8_t width)
+{
+    uint32_t scale = 1;
+    uint32_t mag = value < 0 ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    char body[REF_MAX];
+    uint8_t i;
+
+    for (i = 0; i < places; i++) {
+        scale *= 10;
+    }
+    snprintf(body, sizeof(body), "%s%lu.%0*lu", value < 0 ? "-" : "",
+             (unsigned long)(mag / scale), places, (unsigned long)(mag % scale));
+    snprintf(out, REF_MAX, "%*s", width, body);
+}
+
+static void
+testKnown(void)
+{
+    char *end;
+
+    guard();
+    end = fmtInt(g_buf, INT32_MIN, 0);
+    CHECK(matches(end, "-2147483648"));
+
+    guard();
+    end = fmtUint(g_buf, UINT32_MAX, 12);
+    CHECK(matches(end, "  4294967295"));
+
+    guard();
+    end = fmtFixed(g_buf, 1234, 2, 0);
+    CHECK(matches(end, "12.34"));
+
+    guard();
+    end = fmtFixed(g_buf, -5, 3, 8);
+    CHECK(matches(end, "  -0.005"));
+
+    guard();
+    end = fmtFixed(g_buf, INT32_MIN, 4, FIELD_MAX);
+    CHECK(matches(end, "        -214748.3648"));
+
+    // Wider than the field: written in full
+    guard();
+    end = fmtFixed(g_buf, 123456, 1, 3);
+    CHECK(matches(end, "12345.6"));
+
+    // The most places, and more taken as the most
+    guard();
+    end = fmtFixed(g_buf, INT32_MIN, FMT_FIXED_MAX_PLACES, 0);
+    CHECK(matches(end, "-2.147483648"));
+
+    guard();
+    end = fmtFixed(g_buf, 7, FMT_FIXED_MAX_PLACES + 1, 0);
+    CHECK(matches(end, "0.000000007"));
+
+    guard();
+    end = fmtFixed(g_buf, -1, 255, 14);
+    CHECK(matches(end, "  -0.000000001"));
+}
+
+static void
+testRandom(void)
+{
+    char expected[REF_MAX];
+    uint32_t failures = 0;
+    uint32_t n;
+
+    srand(42);
+
+    for (n = 0; n < 200000; n++) {
+        int32_t value = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+        uint8_t width = rand() % (FIELD_MAX + 1);
+        uint8_t places = 1 + rand() % FMT_FIXED_MAX_PLACES;
+        char *end;
+
+        // Small values too, so padding is exercised
+        if (n & 1) {
+            value %= 100000;
+        }
+
+        guard();
+        end = fmtInt(g_buf, value, width);
+        snprintf(expected, sizeof(expected), "%*ld", width, (long)value);
+        failures += !matches(end, expected);
+
+        guard();
+        end = fmtFixed(g_buf, value, places, width);
+        fixedReference(expected, value, places, width);
+        failures += !matches(end, expected);
+    }
+
+    CHECK_EQ(failures, 0);
+}
+
+int
+main(void)
+{
+    testKnown();
+    testRandom();
+
+    return checkResult("test_num_format");
+}
+
+#endif /* HOST_TEST */
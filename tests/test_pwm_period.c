@@ -0,0 +1,198 @@
+/*
+ * test_pwm_period.c
+ *
+ * Host test for pwmPeriodTicks() (pwmPeriod.c): every divider the PWM
+ * clock offers, every frequency up to 25 kHz, at several system
+ * clocks, against a 64-bit reference. Checks the 16-bit limit, the
+ * 100-tick floor, round-down and the resulting frequency error.
+ *
+ * Also pwmDutyTicks(): every permille and percent at each profile
+ * period against a 64-bit reference, the ends of the scale, and that
+ * a permille step always moves the compare at the default period.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "check.h"
+#include "pwmControl.h"
+
+#define FREQ_MAX                25000
+#define PERMILLE_FULL           1000
+#define PERCENT_FULL            100
+
+static const uint32_t g_clocks[] = {16000000, 20000000, 40000000, 50000000, 80000000};
+static const uint16_t g_dividers[] = {1, 2, 4, 8, 16, 32, 64};
+
+#define NUM_CLOCKS              (sizeof(g_clocks) / sizeof(g_clocks[0]))
+#define NUM_DIVIDERS            (sizeof(g_dividers) / sizeof(g_dividers[0]))
+
+// Profile periods at 20 MHz, plus the 16-bit limit and the floor
+static const uint32_t g_periods[] = {25000, 40000, 20000, 10000, 4000,
+                                     PWM_PERIOD_MAX, PWM_PERIOD_MIN};
+
+#define NUM_PERIODS             (sizeof(g_periods) / sizeof(g_periods[0]))
+
+static uint32_t
+refPeriod(uint32_t clock, uint32_t freq, uint16_t divider)
+{
+    uint64_t period = (uint64_t)clock / ((uint64_t)divider * freq);
+
+    if (period > PWM_PERIOD_MAX || period < PWM_PERIOD_MIN) {
+        return 0;
+    }
+
+    return (uint32_t)period;
+}
+
+static void
+testSweep(void)
+{
+    uint32_t c;
+    uint32_t d;
+    uint32_t freq;
+
+    for (c = 0; c < NUM_CLOCKS; c++) {
+        for (d = 0; d < NUM_DIVIDERS; d++) {
+            for (freq = 1; freq <= FREQ_MAX; freq++) {
+                uint32_t clock = g_clocks[c];
+                uint16_t divider = g_dividers[d];
+                uint32_t period = pwmPeriodTicks(clock, freq, divider);
+                uint64_t ticks;
+
+                CHECK_EQ(period, refPeriod(clock, freq, divider));
+                if (period == 0) {
+                    continue;
+                }
+
+                // Rounding down leaves the real frequency at or just
+                // above the request, by less than one tick's worth
+                ticks = (uint64_t)clock / divider;
+                CHECK(ticks >= (uint64_t)period * freq);
+                CHECK(ticks < (uint64_t)(period + 1) * freq);
+            }
+        }
+    }
+}
+
+static void
+testLimits(void)
+{
+    // 20 MHz undivided: 305 Hz needs 65573 ticks, 306 Hz fits
+    CHECK_EQ(pwmPeriodTicks(20000000, 305, 1), 0);
+    CHECK_EQ(pwmPeriodTicks(20000000, 306, 1), 65359);
+
+    // Exactly 0xFFFF ticks is allowed, one more is not
+    CHECK_EQ(pwmPeriodTicks(PWM_PERIOD_MAX * 100, 100, 1), PWM_PERIOD_MAX);
+    CHECK_EQ(pwmPeriodTicks((PWM_PERIOD_MAX + 1) * 100, 100, 1), 0);
+
+    // The 100-tick floor, either side
+    CHECK_EQ(pwmPeriodTicks(20000000, 200000, 1), PWM_PERIOD_MIN);
+    CHECK_EQ(pwmPeriodTicks(20000000, 200001, 1), 0);
+
+    // Nothing to divide by
+    CHECK_EQ(pwmPeriodTicks(20000000, 0, 4), 0);
+    CHECK_EQ(pwmPeriodTicks(20000000, 200, 0), 0);
+
+    // Largest inputs don't overflow
+    CHECK_EQ(pwmPeriodTicks(UINT32_MAX, 1, 64), 0);
+    CHECK_EQ(pwmPeriodTicks(UINT32_MAX, UINT32_MAX, 1), 0);
+}
+
+// The frequency profiles at the 20 MHz system clock
+static void
+testProfiles(void)
+{
+    CHECK_EQ(pwmPeriodTicks(20000000, 200, 4), 25000);
+    CHECK_EQ(pwmPeriodTicks(20000000, 500, 1), 40000);
+    CHECK_EQ(pwmPeriodTicks(20000000, 1000, 1), 20000);
+    CHECK_EQ(pwmPeriodTicks(20000000, 2000, 1), 10000);
+    CHECK_EQ(pwmPeriodTicks(20000000, 5000, 1), 4000);
+
+    // 200 Hz only fits once divided
+    CHECK_EQ(pwmPeriodTicks(20000000, 200, 1), 0);
+    CHECK_EQ(pwmPeriodTicks(20000000, 200, 2), 50000);
+}
+
+static uint32_t
+refDuty(uint32_t period, uint32_t duty, uint32_t full)
+{
+    if (duty >= full) {
+        return period;
+    }
+
+    return (uint32_t)((uint64_t)period * duty / full);
+}
+
+static void
+testDutySweep(void)
+{
+    uint32_t p;
+    uint32_t duty;
+
+    for (p = 0; p < NUM_PERIODS; p++) {
+        uint32_t period = g_periods[p];
+        uint32_t last = 0;
+
+        for (duty = 0; duty <= PERMILLE_FULL + 10; duty++) {
+            uint32_t ticks = pwmDutyTicks(period, duty, PERMILLE_FULL);
+
+            CHECK_EQ(ticks, refDuty(period, duty, PERMILLE_FULL));
+            CHECK(ticks <= period);
+            CHECK(ticks >= last);
+            last = ticks;
+        }
+
+        for (duty = 0; duty <= PERCENT_FULL + 10; duty++) {
+            CHECK_EQ(pwmDutyTicks(period, duty, PERCENT_FULL),
+                     refDuty(period, duty, PERCENT_FULL));
+        }
+    }
+}
+
+static void
+testDutyLimits(void)
+{
+    uint32_t duty;
+
+    // Zero is off, full scale and beyond is the whole period
+    CHECK_EQ(pwmDutyTicks(25000, 0, PERMILLE_FULL), 0);
+    CHECK_EQ(pwmDutyTicks(25000, PERMILLE_FULL, PERMILLE_FULL), 25000);
+    CHECK_EQ(pwmDutyTicks(25000, PERMILLE_FULL + 1, PERMILLE_FULL), 25000);
+    CHECK_EQ(pwmDutyTicks(25000, UINT32_MAX, PERMILLE_FULL), 25000);
+    CHECK_EQ(pwmDutyTicks(25000, 0, 0), 0);
+    CHECK_EQ(pwmDutyTicks(25000, 500, 0), 0);
+
+    // One step below full scale at the 16-bit limit doesn't overflow
+    CHECK_EQ(pwmDutyTicks(PWM_PERIOD_MAX, PERMILLE_FULL - 1, PERMILLE_FULL), 65469);
+    CHECK_EQ(pwmDutyTicks(PWM_PERIOD_MAX, 65535, 65536), 65534);
+
+    // The controller limits at the default period
+    CHECK_EQ(pwmDutyTicks(25000, 20, PERMILLE_FULL), 500);
+    CHECK_EQ(pwmDutyTicks(25000, 980, PERMILLE_FULL), 24500);
+
+    // At 25000 ticks every permille is its own compare value,
+    // 25 ticks apart; percent only reaches every tenth of them
+    for (duty = 1; duty <= PERMILLE_FULL; duty++) {
+        CHECK_EQ(pwmDutyTicks(25000, duty, PERMILLE_FULL) -
+                 pwmDutyTicks(25000, duty - 1, PERMILLE_FULL), 25);
+    }
+    CHECK_EQ(pwmDutyTicks(25000, 1, PERCENT_FULL),
+             pwmDutyTicks(25000, 10, PERMILLE_FULL));
+}
+
+int
+main(void)
+{
+    testSweep();
+    testLimits();
+    testProfiles();
+    testDutySweep();
+    testDutyLimits();
+
+    return checkResult("test_pwm_period");
+}
+
+#endif /* HOST_TEST */
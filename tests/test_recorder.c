@@ -0,0 +1,210 @@
+/*
+ * test_recorder.c
+ *
+ * Round trip of the flight recorder through tools/blackbox_decode.py.
+ * Logs a known series of records with recorder.c, long enough to wrap
+ * the ring several times, dumps it through telemetry.c and the fake
+ * uDMA engine, and writes the captured stream and the CSV the decoder
+ * should produce for it. The Makefile runs the decoder on the stream
+ * and diffs the two.
+ *
+ * The expected CSV holds the records of the last RECORDER_BLOCKS
+ * blocks. Which record starts the oldest of those is worked out from
+ * the block headers handed to flashLogAppend(), not from recorder.c's
+ * internals.
+ *
+ *   test_recorder <dump.bin> <expected.csv>
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "recorder.h"
+#include "uartDma.h"
+
+#define NUM_RECORDS             6000
+#define MAX_SEQUENCE            2000    // Blocks the run may start
+#define DUMP_POLLS              2000
+
+typedef struct {
+    uint32_t timestamp;
+    int16_t altitude;
+    int16_t desired_alt;
+    int16_t yaw;
+    int16_t desired_yaw;
+    uint16_t main_duty;
+    uint16_t tail_duty;
+    uint8_t mode;
+    uint32_t loop_cycles;
+} record_t;
+
+static record_t g_records[NUM_RECORDS];
+static uint32_t g_numRecords;
+
+// First timestamp of each block, by sequence number, from the block
+// headers passed to the flash log
+static uint32_t g_blockStart[MAX_SEQUENCE];
+static uint32_t g_lastSequence;
+
+static uint32_t
+getU32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void flashLogAppend(const uint8_t *block)
+{
+    uint32_t sequence = getU32(block);
+
+    if (sequence < MAX_SEQUENCE) {
+        g_blockStart[sequence] = getU32(block + 4);
+    }
+    g_lastSequence = sequence;
+}
+
+static int32_t
+randomRange(int32_t low, int32_t high)
+{
+    return low + (int32_t)(((uint32_t)rand() << 8 ^ (uint32_t)rand())
+                           % (uint32_t)(high - low + 1));
+}
+
+// Random walks with occasional jumps to the extremes, gaps in time
+// and repeated ticks, starting just before the timestamp wraps
+static void
+logRecords(void)
+{
+    record_t r = {0xFFFFFE00u, 0, 0, 0, 0, 0, 0, 0, 0};
+    uint32_t n;
+
+    srand(44);
+
+    for (n = 0; n < NUM_RECORDS; n++) {
+        switch (rand() % 16) {
+            case 0: r.timestamp += randomRange(2, 200000); break;
+            case 1: break;                      // Same tick, not recorded
+            default: r.timestamp++; break;
+        }
+
+        r.altitude += randomRange(-3, 3);
+        r.desired_alt = (rand() % 50 == 0) ? randomRange(0, 100) : r.desired_alt;
+        r.yaw += randomRange(-20, 20);
+        r.desired_yaw = (rand() % 50 == 0) ? randomRange(-180, 179) : r.desired_yaw;
+        r.main_duty = randomRange(0, 100);
+        r.tail_duty = randomRange(0, 100);
+        r.mode = (rand() % 100 == 0) ? randomRange(0, 3) : r.mode;
+        r.loop_cycles = randomRange(0, 20000);
+
+        if (rand() % 200 == 0) {
+            r.altitude = (rand() & 1) ? INT16_MAX : INT16_MIN;
+            r.yaw = (rand() & 1) ? INT16_MAX : INT16_MIN;
+            r.main_duty = UINT16_MAX;
+            r.loop_cycles = (rand() & 1) ? UINT32_MAX : 0x80000000u;
+        }
+
+        if (g_numRecords == 0 || r.timestamp != g_records[g_numRecords - 1].timestamp) {
+            g_records[g_numRecords++] = r;
+        }
+        recorderLog(r.timestamp, r.main_duty, r.tail_duty, r.altitude,
+                    r.desired_alt, r.yaw, r.desired_yaw, r.mode, r.loop_cycles);
+    }
+}
+
+// Dump the ring through the fake uDMA engine into a file
+static uint32_t
+dump(FILE *out)
+{
+    uint8_t buf[UART_DMA_BUF_SIZE];
+    uint32_t bytes = 0;
+    uint16_t len;
+    uint32_t n;
+
+    recorderStartDump();
+    for (n = 0; n < DUMP_POLLS; n++) {
+        recorderPoll();
+        uartDmaSimComplete();
+        uartDmaPoll();
+        uartDmaStart();
+
+        while ((len = uartDmaSimOutput(buf, sizeof(buf))) > 0) {
+            fwrite(buf, 1, len, out);
+            bytes += len;
+        }
+    }
+    return bytes;
+}
+
+// Write the records from the oldest surviving block on as CSV
+static uint32_t
+writeExpected(FILE *out)
+{
+    uint32_t oldest = g_lastSequence - (RECORDER_BLOCKS - 1);
+    uint32_t first;
+    uint32_t n;
+
+    for (first = 0; first < g_numRecords; first++) {
+        if (g_records[first].timestamp == g_blockStart[oldest]) {
+            break;
+        }
+    }
+
+    fprintf(out, "timestamp,alt,desired_alt,yaw,desired_yaw,main_duty,"
+                 "tail_duty,mode,loop_cycles\n");
+    for (n = first; n < g_numRecords; n++) {
+        const record_t *r = &g_records[n];
+
+        fprintf(out, "%lu,%d,%d,%d,%d,%u,%u,%u,%lu\n",
+                (unsigned long)r->timestamp, r->altitude, r->desired_alt,
+                r->yaw, r->desired_yaw, r->main_duty, r->tail_duty, r->mode,
+                (unsigned long)r->loop_cycles);
+    }
+    return g_numRecords - first;
+}
+
+int
+main(int argc, char *argv[])
+{
+    FILE *dumpFile;
+    FILE *csvFile;
+    uint32_t expected;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: test_recorder dump.bin expected.csv\n");
+        return 2;
+    }
+
+    dumpFile = fopen(argv[1], "wb");
+    csvFile = fopen(argv[2], "w");
+    if (!dumpFile || !csvFile) {
+        perror("test_recorder");
+        return 2;
+    }
+
+    uartDmaSimReset();
+    initRecorder();
+    logRecords();
+
+    // The run must wrap the ring, and the freeze persists the last block
+    CHECK(dump(dumpFile) > RECORDER_BLOCKS * RECORDER_BLOCK_SIZE);
+    CHECK(g_lastSequence > 2 * RECORDER_BLOCKS);
+    CHECK(g_lastSequence < MAX_SEQUENCE);
+    CHECK_EQ(getRecorderCause(), REC_CAUSE_COMMAND);
+    CHECK_EQ(uartDmaDropped(), 0);
+
+    // Every record of the surviving blocks is expected
+    expected = writeExpected(csvFile);
+    CHECK(expected > RECORDER_BLOCKS * 10);
+    CHECK(expected < g_numRecords);
+
+    fclose(dumpFile);
+    fclose(csvFile);
+
+    return checkResult("test_recorder");
+}
+
+#endif /* HOST_TEST */
@@ -0,0 +1,270 @@
+/*
+ * test_telemetry.c
+ *
+ * Round trip of the binary telemetry stream through
+ * tools/telemetry_decode.py. Sends flight frames and channel frames,
+ * under changing subscriptions and decimations, through telemetry.c
+ * and the fake uDMA engine, and writes the captured stream and the CSV
+ * the decoder should produce for it. The Makefile runs the decoder on
+ * the stream and diffs the two.
+ *
+ * Two bad frames are mixed in, and must not reach the CSV: one with a
+ * corrupted byte, and one whose last COBS code byte runs one past the
+ * end of the frame but which otherwise decodes to a valid frame.
+ *
+ *   test_telemetry <stream.bin> <expected.csv>
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "telemetry.h"
+#include "uartDma.h"
+
+#define NUM_FRAMES              3000
+#define RESUBSCRIBE_FRAMES      100     // Channel frames per subscription set
+#define DECIMATION_MAX          4
+
+static const char *const g_channelNames[NUM_TELEMETRY_CHANNELS] = {
+    "alt", "desired_alt", "yaw", "desired_yaw", "main_duty", "tail_duty",
+    "mode", "alt_p", "alt_i", "alt_d", "yaw_p", "yaw_i", "yaw_d",
+    "loop_cycles",
+};
+
+static uint8_t g_decimation[NUM_TELEMETRY_CHANNELS];
+static uint32_t g_sinceSubscribe;       // Channel frames since subscribing
+static uint16_t g_sequence;
+static uint32_t g_frames;               // Frames written to the CSV
+
+static int32_t
+randomRange(int32_t low, int32_t high)
+{
+    return low + (int32_t)(((uint32_t)rand() << 16 ^ (uint32_t)rand())
+                           % ((uint32_t)(high - low) + 1));
+}
+
+static uint32_t
+randomU32(void)
+{
+    return (uint32_t)rand() << 16 ^ (uint32_t)rand() << 1 ^ (uint32_t)rand();
+}
+
+// Send everything queued into the file
+static void
+drain(FILE *out)
+{
+    uint8_t buf[UART_DMA_BUF_SIZE];
+    uint16_t len;
+    uint8_t n;
+
+    for (n = 0; n < UART_DMA_NUM_BUFS + 1; n++) {
+        uartDmaSimComplete();
+        uartDmaPoll();
+        uartDmaStart();
+        while ((len = uartDmaSimOutput(buf, sizeof(buf))) > 0) {
+            fwrite(buf, 1, len, out);
+        }
+    }
+}
+
+static void
+sendFlight(FILE *csv)
+{
+    uint32_t timestamp = randomU32();
+    uint16_t main_duty = randomRange(0, UINT16_MAX);
+    uint16_t tail_duty = randomRange(0, UINT16_MAX);
+    int16_t altitude = randomRange(INT16_MIN, INT16_MAX);
+    int16_t desired_alt = randomRange(INT16_MIN, INT16_MAX);
+    int16_t yaw = randomRange(INT16_MIN, INT16_MAX);
+    int16_t desired_yaw = randomRange(INT16_MIN, INT16_MAX);
+    uint8_t mode = randomRange(0, UINT8_MAX);
+
+    sendTelemetryFrame(timestamp, main_duty, tail_duty, altitude,
+                       desired_alt, yaw, desired_yaw, mode);
+
+    fprintf(csv, "%u,%lu,%d,%d,%d,%d,%u,%u,%u,,,,,,,\n", g_sequence++,
+            (unsigned long)timestamp, altitude, desired_alt, yaw,
+            desired_yaw, main_duty, tail_duty, mode);
+    g_frames++;
+}
+
+// Pick new decimations (0, off, for about one channel in five)
+static void
+resubscribe(void)
+{
+    uint8_t ch;
+
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        g_decimation[ch] = (rand() % 5 == 0) ? 0 : randomRange(1, DECIMATION_MAX);
+        CHECK(telemetrySubscribe(ch, g_decimation[ch]));
+    }
+    g_sinceSubscribe = 0;
+}
+
+static void
+sendChannels(FILE *csv)
+{
+    int32_t values[NUM_TELEMETRY_CHANNELS];
+    bool due[NUM_TELEMETRY_CHANNELS];
+    uint32_t timestamp = randomU32();
+    bool any = false;
+    uint8_t ch;
+
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        if (ch == TCH_MODE) {
+            values[ch] = randomRange(0, UINT8_MAX);
+        }
+        else if (ch == TCH_LOOP_CYCLES) {
+            values[ch] = (int32_t)randomU32();
+        }
+        else {
+            values[ch] = randomRange(INT16_MIN, INT16_MAX);
+        }
+        telemetryPublish(ch, values[ch]);
+    }
+
+    sendTelemetryChannels(timestamp);
+
+    // A channel subscribed at decimation d is in the first frame after
+    // subscribing and every d'th frame after that
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        due[ch] = g_decimation[ch] != 0
+                  && g_sinceSubscribe % g_decimation[ch] == 0;
+        any = any || due[ch];
+    }
+    g_sinceSubscribe++;
+
+    // No channel due: no frame, and no sequence number used
+    if (!any) {
+        return;
+    }
+
+    fprintf(csv, "%u,%lu", g_sequence++, (unsigned long)timestamp);
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        if (!due[ch]) {
+            fprintf(csv, ",");
+        }
+        else if (ch == TCH_LOOP_CYCLES) {
+            fprintf(csv, ",%lu", (unsigned long)(uint32_t)values[ch]);
+        }
+        else {
+            fprintf(csv, ",%ld", (long)values[ch]);
+        }
+    }
+    fprintf(csv, "\n");
+    g_frames++;
+}
+
+// Append a frame that is only valid if the decoder lets the last COBS
+// code byte run one past the end of the block
+static void
+writeOverrun(FILE *out)
+{
+    uint8_t frame[TELEMETRY_FRAME_LEN];
+    uint8_t encoded[COBS_MAX_LEN(TELEMETRY_FRAME_LEN)];
+    uint16_t len;
+    uint16_t i = 0;
+    uint8_t n;
+
+    // Non-zero bytes, ending with a short group
+    frame[0] = TELEMETRY_TYPE_FLIGHT;
+    for (n = 1; n < TELEMETRY_FRAME_LEN - TELEMETRY_CRC_LEN; n++) {
+        frame[n] = n;
+    }
+    putU16(frame + TELEMETRY_FRAME_LEN - TELEMETRY_CRC_LEN,
+           crc16Ccitt(frame, TELEMETRY_FRAME_LEN - TELEMETRY_CRC_LEN));
+    len = cobsEncode(frame, TELEMETRY_FRAME_LEN, encoded);
+
+    // Find the last group and claim one more byte than it has
+    while (i + encoded[i] < len - 1) {
+        i += encoded[i];
+    }
+    encoded[i]++;
+    fwrite(encoded, 1, len, out);
+}
+
+// Append a good frame with one byte flipped
+static void
+writeCorrupt(FILE *out)
+{
+    uint8_t frame[TELEMETRY_FRAME_LEN] = {TELEMETRY_TYPE_FLIGHT, 1, 2, 3};
+    uint8_t encoded[COBS_MAX_LEN(TELEMETRY_FRAME_LEN)];
+    uint16_t len;
+
+    putU16(frame + TELEMETRY_FRAME_LEN - TELEMETRY_CRC_LEN,
+           crc16Ccitt(frame, TELEMETRY_FRAME_LEN - TELEMETRY_CRC_LEN));
+    len = cobsEncode(frame, TELEMETRY_FRAME_LEN, encoded);
+    encoded[len / 2] ^= 0x40;
+    fwrite(encoded, 1, len, out);
+}
+
+int
+main(int argc, char *argv[])
+{
+    FILE *streamFile;
+    FILE *csvFile;
+    uint8_t ch;
+    uint32_t n;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: test_telemetry stream.bin expected.csv\n");
+        return 2;
+    }
+
+    streamFile = fopen(argv[1], "wb");
+    csvFile = fopen(argv[2], "w");
+    if (!streamFile || !csvFile) {
+        perror("test_telemetry");
+        return 2;
+    }
+
+    srand(45);
+    uartDmaSimReset();
+
+    fprintf(csvFile, "seq,timestamp");
+    for (ch = 0; ch < NUM_TELEMETRY_CHANNELS; ch++) {
+        fprintf(csvFile, ",%s", g_channelNames[ch]);
+    }
+    fprintf(csvFile, "\n");
+
+    // Nothing subscribed: no channel frame
+    sendTelemetryChannels(0);
+    drain(streamFile);
+    CHECK_EQ(ftell(streamFile), 0);
+
+    for (n = 0; n < NUM_FRAMES; n++) {
+        if (n % (2 * RESUBSCRIBE_FRAMES) == 0) {
+            resubscribe();
+        }
+        if (rand() % 2) {
+            sendFlight(csvFile);
+        }
+        else {
+            sendChannels(csvFile);
+        }
+        drain(streamFile);
+
+        if (n == NUM_FRAMES / 3) {
+            writeOverrun(streamFile);
+        }
+        if (n == 2 * NUM_FRAMES / 3) {
+            writeCorrupt(streamFile);
+        }
+    }
+
+    CHECK(g_frames > NUM_FRAMES * 3 / 4);
+    CHECK_EQ(uartDmaDropped(), 0);
+    CHECK_EQ(uartDmaSimOverlaps(), 0);
+
+    fclose(streamFile);
+    fclose(csvFile);
+
+    return checkResult("test_telemetry");
+}
+
+#endif /* HOST_TEST */
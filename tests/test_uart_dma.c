@@ -0,0 +1,258 @@
+/*
+ * test_uart_dma.c
+ *
+ * Host test for uartDma.c, the uDMA frame double buffer, against the
+ * fake engine in uartDmaSim.c: buffer exhaustion and the drop count,
+ * completion recycling a buffer and starting the next, frames leaving
+ * in submit order whichever buffer they were built in, and a long
+ * randomized stream checked for order, loss and overlapping
+ * transfers.
+ *
+ * uartDma.c keeps its state in statics, so each test leaves every
+ * buffer free again before returning.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "uartDma.h"
+
+// Play the UART interrupt: recycle a finished transfer, start the next
+static void
+interrupt(void)
+{
+    uartDmaPoll();
+    uartDmaStart();
+}
+
+// Finish transfers until nothing is queued
+static void
+drain(void)
+{
+    while (uartDmaSimRunning()) {
+        uartDmaSimComplete();
+        interrupt();
+    }
+}
+
+static void
+submitText(uint8_t *buf, const char *text)
+{
+    uint16_t len = strlen(text);
+
+    memcpy(buf, text, len);
+    uartDmaSubmit(buf, len);
+}
+
+static void
+checkOutput(const char *expected)
+{
+    uint8_t out[64];
+    uint16_t len = uartDmaSimOutput(out, sizeof(out));
+
+    CHECK_EQ(len, strlen(expected));
+    CHECK(memcmp(out, expected, len) == 0);
+}
+
+static void
+testExhaustion(void)
+{
+    uint32_t dropped = uartDmaDropped();
+    uint8_t *a = uartDmaAcquire();
+    uint8_t *b = uartDmaAcquire();
+
+    CHECK(a != 0);
+    CHECK(b != 0);
+    CHECK(a != b);
+
+    // Both buffers are being filled; the third frame is dropped
+    CHECK(uartDmaAcquire() == 0);
+    CHECK_EQ(uartDmaDropped(), dropped + 1);
+
+    // Nothing reaches the wire until a buffer is submitted
+    CHECK(!uartDmaSimRunning());
+    CHECK(!uartDmaBusy());
+
+    submitText(a, "one");
+    submitText(b, "two");
+    drain();
+    checkOutput("onetwo");
+    CHECK_EQ(uartDmaDropped(), dropped + 1);
+}
+
+static void
+testRecycle(void)
+{
+    uint8_t *a = uartDmaAcquire();
+    uint8_t *b;
+    uint8_t *c;
+
+    // A submit to an idle line starts at once
+    submitText(a, "A");
+    CHECK(uartDmaSimRunning());
+    CHECK(uartDmaBusy());
+
+    // The second waits behind it
+    b = uartDmaAcquire();
+    submitText(b, "B");
+    CHECK(uartDmaAcquire() == 0);
+
+    // Completion alone frees nothing; the interrupt recycles the buffer
+    // and starts the queued one
+    uartDmaSimComplete();
+    CHECK(uartDmaBusy());
+    interrupt();
+    CHECK(uartDmaSimRunning());
+    checkOutput("A");
+
+    // The recycled buffer is the one that was sent
+    c = uartDmaAcquire();
+    CHECK(c == a);
+    CHECK(uartDmaAcquire() == 0);
+    submitText(c, "C");
+
+    drain();
+    checkOutput("BC");
+    CHECK(!uartDmaBusy());
+}
+
+static void
+testLineBusy(void)
+{
+    uint8_t *a = uartDmaAcquire();
+    uint8_t *b = uartDmaAcquire();
+
+    // With byte-at-a-time output pending, both frames queue; they go in
+    // submit order once the line frees, not buffer order
+    uartDmaSimSetLineFree(false);
+    submitText(b, "first");
+    submitText(a, "second");
+    CHECK(!uartDmaSimRunning());
+    interrupt();
+    CHECK(!uartDmaSimRunning());
+
+    uartDmaSimSetLineFree(true);
+    interrupt();
+    drain();
+    checkOutput("firstsecond");
+}
+
+// Check each whole frame in the output log against its sequence number
+static bool
+checkFrames(uint32_t *received)
+{
+    uint8_t out[UART_DMA_BUF_SIZE * 4];
+    uint16_t len = uartDmaSimOutput(out, sizeof(out));
+    uint16_t i = 0;
+    bool ok = true;
+
+    while (i < len) {
+        uint16_t frameLen = out[i + 1];
+        uint16_t j;
+
+        ok = ok && out[i] == (*received & 0xFF);
+        for (j = 2; j < frameLen; j++) {
+            ok = ok && out[i + j] == (uint8_t)(*received * 7 + j);
+        }
+        i += frameLen;
+        (*received)++;
+    }
+
+    return ok && i == len;
+}
+
+//**********************************************************************
+// Random interleave of acquire, submit, completion and line busy. Each
+// frame carries a sequence number and a pattern derived from it; the
+// output must be the submitted frames, whole and in order.
+//**********************************************************************
+static void
+testStream(void)
+{
+    uint8_t *filling[UART_DMA_NUM_BUFS];
+    uint16_t nFilling = 0;
+    uint32_t attempted = 0;
+    uint32_t submitted = 0;
+    uint32_t received = 0;
+    uint32_t dropped = uartDmaDropped();
+    uint32_t step;
+    bool ok = true;
+
+    srand(39);
+
+    for (step = 0; step < 20000; step++) {
+        int action = rand() % 5;
+        uint16_t len;
+        uint16_t i;
+
+        if (action == 0) {
+            uint8_t *buf = uartDmaAcquire();
+
+            attempted++;
+            if (buf) {
+                filling[nFilling++] = buf;
+            }
+        }
+        else if (action == 1 && nFilling > 0) {
+            uint8_t *buf = filling[--nFilling];
+
+            len = 2 + rand() % (UART_DMA_BUF_SIZE - 1);
+            buf[0] = submitted & 0xFF;
+            buf[1] = len;
+            for (i = 2; i < len; i++) {
+                buf[i] = (uint8_t)(submitted * 7 + i);
+            }
+            uartDmaSubmit(buf, len);
+            submitted++;
+        }
+        else if (action == 2) {
+            uartDmaSimComplete();
+        }
+        else if (action == 3) {
+            uartDmaSimSetLineFree(rand() % 4 != 0);
+        }
+        interrupt();
+        ok = checkFrames(&received) && ok;
+        ok = ok && uartDmaSimLockDepth() == 0;
+    }
+
+    while (nFilling > 0) {
+        uint8_t *buf = filling[--nFilling];
+
+        buf[0] = submitted & 0xFF;
+        buf[1] = 2;
+        uartDmaSubmit(buf, 2);
+        submitted++;
+    }
+    uartDmaSimSetLineFree(true);
+    interrupt();
+    drain();
+    ok = checkFrames(&received) && ok;
+
+    CHECK(ok);
+    CHECK(submitted > 1000);
+    CHECK_EQ(received, submitted);
+    CHECK_EQ(submitted + uartDmaDropped() - dropped, attempted);
+    CHECK_EQ(uartDmaSimOverlaps(), 0);
+    CHECK_EQ(uartDmaSimLockDepth(), 0);
+}
+
+int
+main(void)
+{
+    uartDmaSimReset();
+
+    testExhaustion();
+    testRecycle();
+    testLineBusy();
+    testStream();
+
+    return checkResult("test_uart_dma");
+}
+
+#endif /* HOST_TEST */
@@ -0,0 +1,109 @@
+/*
+ * test_yaw.c
+ *
+ * Host test for wrapYaw() and yawError() (yawWrap.c): the wrap
+ * boundaries, whole turns either way, and the shortest-path error
+ * across the +/-180 seam.
+ */
+
+#ifdef HOST_TEST
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "yawDetection.h"
+
+// Reference wrap into [-180, 180), done in 64 bits with a non-negative
+// modulus so it can't share a mistake with the code under test
+static int32_t
+refWrap(int64_t degrees)
+{
+    int64_t m = ((degrees + 180) % 360 + 360) % 360;
+
+    return (int32_t)(m - 180);
+}
+
+static void
+testWrapBoundaries(void)
+{
+    CHECK_EQ(wrapYaw(0), 0);
+    CHECK_EQ(wrapYaw(179), 179);
+    CHECK_EQ(wrapYaw(180), -180);
+    CHECK_EQ(wrapYaw(181), -179);
+    CHECK_EQ(wrapYaw(-179), -179);
+    CHECK_EQ(wrapYaw(-180), -180);
+    CHECK_EQ(wrapYaw(-181), 179);
+    CHECK_EQ(wrapYaw(359), -1);
+    CHECK_EQ(wrapYaw(360), 0);
+    CHECK_EQ(wrapYaw(-360), 0);
+    CHECK_EQ(wrapYaw(540), -180);
+    CHECK_EQ(wrapYaw(-540), -180);
+    CHECK_EQ(wrapYaw(INT32_MAX), refWrap(INT32_MAX));
+    CHECK_EQ(wrapYaw(INT32_MIN), refWrap(INT32_MIN));
+}
+
+// Every angle over several turns each way
+static void
+testWrapSweep(void)
+{
+    int32_t d;
+
+    for (d = -3 * 360; d <= 3 * 360; d++) {
+        int32_t w = wrapYaw(d);
+
+        CHECK_EQ(w, refWrap(d));
+        CHECK(w >= -180 && w < 180);
+    }
+}
+
+static void
+testErrorSeam(void)
+{
+    // Either side of the seam is 2 degrees apart, not 358
+    CHECK_EQ(yawError(179, -179), -2);
+    CHECK_EQ(yawError(-179, 179), 2);
+    CHECK_EQ(yawError(-180, 179), 1);
+    CHECK_EQ(yawError(179, -180), -1);
+
+    // Half a turn away is always taken as -180
+    CHECK_EQ(yawError(0, 180), -180);
+    CHECK_EQ(yawError(180, 0), -180);
+    CHECK_EQ(yawError(90, -90), -180);
+
+    // Whole turns in the target count for nothing
+    CHECK_EQ(yawError(360, 0), 0);
+    CHECK_EQ(yawError(-360, 0), 0);
+    CHECK_EQ(yawError(375, 0), 15);
+}
+
+// Every pair of wrapped angles: the error is in range, no longer than
+// half a turn, and takes actual to desired
+static void
+testErrorExhaustive(void)
+{
+    int32_t desired;
+    int32_t actual;
+
+    for (desired = -180; desired < 180; desired++) {
+        for (actual = -180; actual < 180; actual++) {
+            int32_t e = yawError(desired, actual);
+
+            CHECK(e >= -180 && e < 180);
+            CHECK_EQ(wrapYaw(actual + e), desired);
+        }
+    }
+}
+
+int
+main(void)
+{
+    testWrapBoundaries();
+    testWrapSweep();
+    testErrorSeam();
+    testErrorExhaustive();
+
+    return checkResult("test_yaw");
+}
+
+#endif /* HOST_TEST */
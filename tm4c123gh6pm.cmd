@@ -10,7 +10,8 @@
 
 MEMORY
 {
-    FLASH (RX) : origin = 0x00000000, length = 0x00040000
+    /* Top 64 kB of flash is kept for the flight log (flashDev.h) */
+    FLASH (RX) : origin = 0x00000000, length = 0x00030000
     SRAM (RWX) : origin = 0x20000000, length = 0x00008000
 }
 
@@ -40,6 +41,10 @@ SECTIONS
     .bss    :   > SRAM
     .sysmem :   > SRAM
     .stack  :   > SRAM
+
+    /* Flight recorder -- not zeroed at start-up so it survives a reset */
+    .blackbox : > SRAM, type = NOINIT
 }
 
-__STACK_TOP = __stack + 512;
+/* Must match --stack_size; see the stack budget in intPriority.h */
+__STACK_TOP = __stack + 2048;
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+blackbox_decode.py
+
+Decode a flight recorder or flash log dump (see recorder.h and
+flashLog.h) into CSV, one row per control tick, oldest first.
+Telemetry frames mixed into the capture are ignored.
+
+Usage:
+    blackbox_decode.py dump.bin > flight.csv
+    blackbox_decode.py /dev/ttyACM0 --baud 9600 --dump > flight.csv
+    blackbox_decode.py /dev/ttyACM0 --baud 115200 --flash > flights.csv
+
+--dump sends REC DUMP first, which freezes the recorder if it is still
+running. --flash sends LOG DUMP to read the flash log instead. The
+decoder stops once the whole ring or log has arrived.
+"""
+
+import argparse
+import struct
+import sys
+
+from telemetry_decode import crc16_ccitt, open_input, raw_frames
+
+FRAME_TYPE_REC_INFO = 0x03
+FRAME_TYPE_REC_DATA = 0x04
+FRAME_TYPE_LOG_INFO = 0x05
+FRAME_TYPE_LOG_DATA = 0x06
+EMPTY = (0, 0xFFFFFFFF)             # Block sequence of an unused block
+HEADER_LEN = 8
+FIELDS = ("timestamp", "alt", "desired_alt", "yaw", "desired_yaw",
+          "main_duty", "tail_duty", "mode", "loop_cycles")
+CAUSES = {0: "none", 1: "command", 2: "kill", 3: "reset button",
+          4: "orient timeout"}
+
+
+def read_varint(data, i):
+    """Return (value, next index), or (None, i) if it runs off the end."""
+    value = 0
+    shift = 0
+    while i < len(data):
+        byte = data[i]
+        i += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, i
+    return None, i
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def decode_block(block):
+    """Yield one dict per record in a block, in order."""
+    _, timestamp = struct.unpack_from("<II", block)
+    timestamp -= 1
+    values = [0] * (len(FIELDS) - 1)
+    i = HEADER_LEN
+    while i < len(block) and block[i] != 0:
+        dt, i = read_varint(block, i)
+        if dt is None:
+            return
+        deltas = []
+        for _ in values:
+            delta, i = read_varint(block, i)
+            if delta is None:
+                return
+            deltas.append(unzigzag(delta))
+        timestamp = (timestamp + dt) & 0xFFFFFFFF
+        values = [v + d for v, d in zip(values, deltas)]
+        values[-1] &= 0xFFFFFFFF        # Loop cycles are unsigned
+        yield dict(zip(FIELDS, [timestamp] + values))
+
+
+def decode_ring(ring, block_size):
+    """Yield every record in the ring, oldest block first."""
+    blocks = []
+    for start in range(0, len(ring), block_size):
+        block = ring[start:start + block_size]
+        sequence = struct.unpack_from("<I", block)[0]
+        if sequence not in EMPTY:
+            blocks.append((sequence, block))
+    for _, block in sorted(blocks, key=lambda b: b[0]):
+        yield from decode_block(block)
+
+
+def read_dump(stream):
+    """Collect a dump from a frame stream. Returns (cause, block size,
+    ring bytes); parts of the ring that never arrived are zero."""
+    cause = None
+    block_size = None
+    ring = None
+    data_type = None
+    received = 0
+    for frame in raw_frames(stream):
+        if frame is None or len(frame) < 3:
+            continue
+        if crc16_ccitt(frame[:-2]) != struct.unpack("<H", frame[-2:])[0]:
+            continue
+        if frame[0] in (FRAME_TYPE_REC_INFO, FRAME_TYPE_LOG_INFO) \
+                and len(frame) == 8:
+            _, cause, block_size, count = struct.unpack_from("<BBHH", frame)
+            ring = bytearray(block_size * count)
+            received = 0
+            data_type = frame[0] + 1
+        elif ring is not None and frame[0] == data_type:
+            if data_type == FRAME_TYPE_REC_DATA:
+                offset = struct.unpack_from("<H", frame, 1)[0]
+                chunk = frame[3:-2]
+            else:
+                offset = struct.unpack_from("<I", frame, 1)[0]
+                chunk = frame[5:-2]
+            ring[offset:offset + len(chunk)] = chunk
+            received += len(chunk)
+            if received >= len(ring):
+                break
+    return cause, block_size, ring
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("input", help="capture file, serial port or - for stdin")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--dump", action="store_true",
+                        help="send REC DUMP before reading")
+    parser.add_argument("--flash", action="store_true",
+                        help="send LOG DUMP before reading")
+    args = parser.parse_args()
+
+    stream = open_input(args.input, args.baud)
+    if args.dump:
+        stream.write(b"REC DUMP\n")
+    elif args.flash:
+        stream.write(b"LOG DUMP\n")
+
+    cause, block_size, ring = read_dump(stream)
+    if ring is None:
+        print("no recorder dump found", file=sys.stderr)
+        sys.exit(1)
+
+    if cause:
+        print("frozen by %s" % CAUSES.get(cause, cause), file=sys.stderr)
+    print(",".join(FIELDS))
+    for record in decode_ring(ring, block_size):
+        print(",".join(str(record[f]) for f in FIELDS))
+
+
+if __name__ == "__main__":
+    main()
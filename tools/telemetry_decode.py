@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""
+telemetry_decode.py
+
+Decode the helicopter controller's binary telemetry stream (see
+telemetry.h) into CSV. Frames are COBS encoded and zero terminated;
+frames with a bad length or CRC are counted and skipped.
+
+Fixed flight frames and channel frames share one set of CSV columns;
+channels missing from a frame are left empty.
+
+Usage:
+    telemetry_decode.py capture.bin > flight.csv
+    telemetry_decode.py /dev/ttyACM0 --baud 9600 > flight.csv
+    telemetry_decode.py /dev/ttyACM0 --negotiate 921600 > flight.csv
+    telemetry_decode.py /dev/ttyACM0 --subscribe alt:1 yaw:1 alt_i:4 > flight.csv
+
+--negotiate asks the controller to change link rate (BAUD/ACK/OK, see
+command.h) before decoding. If the controller doesn't acknowledge, the
+link stays at --baud.
+
+--subscribe switches the controller to channel frames (TEL CH) and
+subscribes to each NAME:DECIMATION given; --rate sets the frame rate.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+FRAME_TYPE_FLIGHT = 0x01
+FRAME_FORMAT = "<BHIhhhhHHBH"
+FRAME_LEN = struct.calcsize(FRAME_FORMAT)
+FRAME_TYPE_CHANNELS = 0x02
+FLIGHT_FIELDS = ("seq", "timestamp", "alt", "desired_alt", "yaw",
+                 "desired_yaw", "main_duty", "tail_duty", "mode")
+
+# Channel registry, in ID order, as enum telemetryChannels
+CHANNELS = (
+    ("alt", "<h"), ("desired_alt", "<h"), ("yaw", "<h"),
+    ("desired_yaw", "<h"), ("main_duty", "<h"), ("tail_duty", "<h"),
+    ("mode", "<B"),
+    ("alt_p", "<h"), ("alt_i", "<h"), ("alt_d", "<h"),
+    ("yaw_p", "<h"), ("yaw_i", "<h"), ("yaw_d", "<h"),
+    ("loop_cycles", "<I"),
+)
+CHANNEL_HEADER = "<BHIH"
+FIELDS = ("seq", "timestamp") + tuple(name for name, _ in CHANNELS)
+
+
+def crc16_ccitt(data):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(block):
+    """Decode one COBS block (without its zero delimiter).
+
+    Returns None if the block is malformed, including a code byte that
+    runs past the end of the block.
+    """
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_channels(frame):
+    """Return a dict of the channels present in a channel frame."""
+    _, seq, timestamp, mask = struct.unpack_from(CHANNEL_HEADER, frame)
+    record = {"seq": seq, "timestamp": timestamp}
+    offset = struct.calcsize(CHANNEL_HEADER)
+    for ch, (name, fmt) in enumerate(CHANNELS):
+        if mask & (1 << ch):
+            record[name] = struct.unpack_from(fmt, frame, offset)[0]
+            offset += struct.calcsize(fmt)
+    if offset != len(frame) - 2 or mask >> len(CHANNELS):
+        return None
+    return record
+
+
+def parse_frame(frame):
+    """Return a dict of fields for a valid frame, else None."""
+    if frame is None or len(frame) < 3:
+        return None
+    if crc16_ccitt(frame[:-2]) != struct.unpack("<H", frame[-2:])[0]:
+        return None
+    if frame[0] == FRAME_TYPE_FLIGHT and len(frame) == FRAME_LEN:
+        values = struct.unpack(FRAME_FORMAT, frame)
+        return dict(zip(FLIGHT_FIELDS, values[1:-1]))
+    if frame[0] == FRAME_TYPE_CHANNELS and len(frame) >= \
+            struct.calcsize(CHANNEL_HEADER) + 2:
+        return parse_channels(frame)
+    return None
+
+
+def raw_frames(stream):
+    """Yield COBS-decoded frames (or None for bad ones) from a byte stream."""
+    block = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            return
+        if chunk[0] == 0:
+            if block:
+                yield cobs_decode(bytes(block))
+            block.clear()
+        else:
+            block += chunk
+
+
+def frames(stream):
+    """Yield decoded frames (or None for bad ones) from a byte stream."""
+    for frame in raw_frames(stream):
+        yield parse_frame(frame)
+
+
+def negotiate(port, baud, timeout=1.0):
+    """Switch the controller and port to baud. Returns True on success."""
+    port.reset_input_buffer()
+    port.write(b"BAUD %d\n" % baud)
+    expected = b"ACK %d" % baud
+    deadline = time.time() + timeout
+    line = b""
+    while time.time() < deadline:
+        line += port.read(port.in_waiting or 1)
+        if expected in line:
+            break
+    else:
+        return False
+
+    # Let the controller finish the ACK and switch before we do
+    time.sleep(0.05)
+    port.baudrate = baud
+    port.reset_input_buffer()
+    port.write(b"OK\n")
+    deadline = time.time() + timeout
+    line = b""
+    while time.time() < deadline:
+        line += port.read(port.in_waiting or 1)
+        if b"READY %d" % baud in line:
+            return True
+    return False
+
+
+def subscribe(port, rate, subscriptions):
+    """Select channel frames and subscribe to NAME:DECIMATION pairs."""
+    names = [name for name, _ in CHANNELS]
+    commands = [b"TEL CH"]
+    if rate:
+        commands.append(b"RATE %d" % rate)
+    for item in subscriptions:
+        name, _, decimation = item.partition(":")
+        commands.append(b"SUB %d %d" % (names.index(name),
+                                        int(decimation or 1)))
+    for command in commands:
+        port.write(command + b"\n")
+        time.sleep(0.05)
+
+
+def open_input(path, baud, new_baud=None, rate=None, subscriptions=()):
+    if path == "-":
+        return sys.stdin.buffer
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial  # pyserial, only needed for live capture
+        port = serial.Serial(path, baud, timeout=0.1)
+        if new_baud and not negotiate(port, new_baud):
+            print("rate change to %d not confirmed, staying at %d"
+                  % (new_baud, baud), file=sys.stderr)
+            # The controller falls back on its own if it saw no OK
+            port.baudrate = baud
+        if subscriptions:
+            subscribe(port, rate, subscriptions)
+        port.timeout = None
+        return port
+    return open(path, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("input", help="capture file, serial port or - for stdin")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--negotiate", type=int, metavar="RATE",
+                        help="change the link to RATE before decoding")
+    parser.add_argument("--subscribe", nargs="+", default=(),
+                        metavar="NAME:DECIMATION",
+                        help="channels to subscribe to, from: %s"
+                        % " ".join(name for name, _ in CHANNELS))
+    parser.add_argument("--rate", type=int, metavar="HZ",
+                        help="channel frame rate, must divide 100")
+    args = parser.parse_args()
+
+    bad = 0
+    print(",".join(FIELDS))
+    try:
+        stream = open_input(args.input, args.baud, args.negotiate,
+                            args.rate, args.subscribe)
+        for record in frames(stream):
+            if record is None:
+                bad += 1
+                continue
+            print(",".join(str(record.get(f, "")) for f in FIELDS))
+    except KeyboardInterrupt:
+        pass
+    if bad:
+        print("%d bad frames skipped" % bad, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
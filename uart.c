@@ -8,18 +8,31 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#include "stdio.h"
-
 #include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_uart.h"
 
 #include "driverlib/gpio.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/uart.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/udma.h"
 
 #include "utils/ustdlib.h"
 
+#include "uart.h"
+#include "intPriority.h"
+#include "dma.h"
+#include "numFormat.h"
+#include "byteRing.h"
+#include "uartDma.h"
+
 //---USB Serial comms: UART0, Rx:PA0 , Tx:PA1
-#define BAUD_RATE               9600
+#define BAUD_RATE               9600        // Rate at power-up
+#define BAUD_RATE_MIN           1200
+#define BAUD_RATE_MAX           921600
+#define UART_CONFIG             (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | \
+                                 UART_CONFIG_PAR_NONE)
 #define UART_USB_BASE           UART0_BASE
 #define UART_USB_PERIPH_UART    SYSCTL_PERIPH_UART0
 #define UART_USB_PERIPH_GPIO    SYSCTL_PERIPH_GPIOA
@@ -28,6 +41,116 @@
 #define UART_USB_GPIO_PIN_TX    GPIO_PIN_1
 #define UART_USB_GPIO_PINS      UART_USB_GPIO_PIN_RX | UART_USB_GPIO_PIN_TX
 
+// Transmit ring buffer, drained into the UART FIFO by the TX interrupt.
+// Size must be a power of two.
+#define UART_TX_BUF_SIZE        256
+
+// uDMA transmit channel for uartDma.c's frame buffers
+#define UART_DMA_CHANNEL        UDMA_CHANNEL_UART0TX
+#define UART_DMA_CHANNEL_ASSIGN UDMA_CH9_UART0TX
+
+// Receive ring buffer, filled by the RX interrupt. Size must be a
+// power of two.
+#define UART_RX_BUF_SIZE        64
+
+//**********************************************************************
+// Globals to module
+//**********************************************************************
+static char g_txBuf[UART_TX_BUF_SIZE];
+static byteRing_t g_txRing = BYTE_RING(g_txBuf);    // Filled by the main loop,
+                                                    // drained under UART mask
+static volatile uint32_t g_txDropped;   // Bytes refused because the buffer was full
+
+static char g_rxBuf[UART_RX_BUF_SIZE];
+static byteRing_t g_rxRing = BYTE_RING(g_rxBuf);    // Filled by the RX interrupt,
+                                                    // drained by the main loop
+static volatile uint32_t g_rxDropped;   // Bytes lost because the buffer was full
+
+static uint32_t g_uartClock;            // System clock, read once at init
+static uint32_t g_baud = BAUD_RATE;     // Rate the UART is running at
+static uint32_t g_pendingBaud;          // Rate to switch to once idle, or 0
+
+//**********************************************************************
+// uartDma.c hooks: the uDMA channel and the UART interrupt mask
+//**********************************************************************
+void
+uartDmaDevStart (const uint8_t *pui8Buf, uint16_t ui16Len)
+{
+    uDMAChannelTransferSet(UART_DMA_CHANNEL | UDMA_PRI_SELECT,
+                           UDMA_MODE_BASIC, (void *)pui8Buf,
+                           (void *)(UART_USB_BASE + UART_O_DR), ui16Len);
+    uDMAChannelEnable(UART_DMA_CHANNEL);
+}
+
+bool
+uartDmaDevDone (void)
+{
+    return uDMAChannelModeGet(UART_DMA_CHANNEL | UDMA_PRI_SELECT) == UDMA_MODE_STOP;
+}
+
+// The ring buffer goes first so text and frames never interleave
+bool
+uartDmaDevLineFree (void)
+{
+    return byteRingEmpty(&g_txRing);
+}
+
+uint32_t
+uartDmaDevLock (void)
+{
+    return criticalEnter(INT_PRIORITY_UART);
+}
+
+void
+uartDmaDevUnlock (uint32_t ui32Key)
+{
+    criticalExit(ui32Key);
+}
+
+//**********************************************************************
+// Move bytes from the ring buffer into the TX FIFO until either runs
+// out. Must run with the UART interrupt masked or from its handler.
+//**********************************************************************
+static void
+uartTxFill (void)
+{
+    char c;
+
+    // The uDMA owns the FIFO while it is sending
+    if (uartDmaBusy()) {
+        return;
+    }
+
+    while (UARTSpaceAvail(UART_USB_BASE) && byteRingGet(&g_txRing, &c))
+    {
+        UARTCharPutNonBlocking(UART_USB_BASE, c);
+    }
+}
+
+//**********************************************************************
+// UART interrupt: the TX FIFO has drained below its trigger level, or
+// a uDMA transfer has finished (signalled on the UART's interrupt)
+//**********************************************************************
+static void
+UARTIntHandler (void)
+{
+    uint32_t status = UARTIntStatus(UART_USB_BASE, true);
+
+    UARTIntClear(UART_USB_BASE, status);
+
+    // Empty the RX FIFO into the ring buffer
+    while (UARTCharsAvail(UART_USB_BASE))
+    {
+        if (!byteRingPut(&g_rxRing, UARTCharGetNonBlocking(UART_USB_BASE))) {
+            g_rxDropped++;
+        }
+    }
+
+    uartDmaPoll();
+    uartTxFill();
+    uartDmaStart();
+}
+
 // Initialize UART output
 void initUART()
 {
@@ -38,29 +161,145 @@ void initUART()
     // Select the alternate (UART) function for these pins.
     GPIOPinTypeUART(UART_USB_GPIO_BASE, UART_USB_GPIO_PINS);
 
-    // REMOVING UART_CONFIG_WLEN_8 from last parameter
-    UARTConfigSetExpClk(UART_USB_BASE, SysCtlClockGet(), BAUD_RATE,
-            UART_CONFIG_WLEN_8 |
-            UART_CONFIG_STOP_ONE |
-            UART_CONFIG_PAR_NONE);
+    g_uartClock = SysCtlClockGet();
+    UARTConfigSetExpClk(UART_USB_BASE, g_uartClock, g_baud, UART_CONFIG);
 
     UARTFIFOEnable(UART_USB_BASE);
+
+    // Interrupt when the TX FIFO drains to 2 of 16 bytes, leaving time
+    // to refill it before the line goes idle
+    UARTFIFOLevelSet(UART_USB_BASE, UART_FIFO_TX2_8, UART_FIFO_RX4_8);
+    UARTTxIntModeSet(UART_USB_BASE, UART_TXINT_MODE_FIFO);
+    UARTIntRegister(UART_USB_BASE, UARTIntHandler);
+    // RX interrupts at half full, or on timeout for a partial FIFO
+    UARTIntEnable(UART_USB_BASE, UART_INT_TX | UART_INT_RX | UART_INT_RT);
+    IntPrioritySet(INT_UART0, INT_PRIORITY_UART);
+    IntEnable(INT_UART0);
+
+    // uDMA transmit: 8-bit writes to the data register, four at a time
+    // as the FIFO requests them
+    initDMA();
+    uDMAChannelAssign(UART_DMA_CHANNEL_ASSIGN);
+    uDMAChannelAttributeDisable(UART_DMA_CHANNEL, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(UART_DMA_CHANNEL | UDMA_PRI_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE |
+                          UDMA_ARB_4);
+    UARTDMAEnable(UART_USB_BASE, UART_DMA_TX);
+
     UARTEnable(UART_USB_BASE);
 }
 
 //**********************************************************************
-// Transmit a string via UART0
+// Queue bytes for transmission without blocking. Returns the number
+// accepted; the rest are dropped and counted.
+//**********************************************************************
+uint16_t
+uartWrite (const char *pcData, uint16_t ui16Len)
+{
+    uint16_t accepted = byteRingWrite(&g_txRing, pcData, ui16Len);
+    uint32_t mask;
+
+    g_txDropped += ui16Len - accepted;
+
+    // The TX interrupt only fires as the FIFO drains, so if it is already
+    // empty nothing will start the transfer -- prime it here
+    mask = criticalEnter(INT_PRIORITY_UART);
+    uartTxFill();
+    criticalExit(mask);
+
+    return accepted;
+}
+
+// Number of bytes dropped because the transmit buffer was full
+uint32_t
+uartTxDropped (void)
+{
+    return g_txDropped;
+}
+
+//**********************************************************************
+// Take up to ui16Max received bytes without blocking. Returns the
+// number read.
+//**********************************************************************
+uint16_t
+uartRead (char *pcData, uint16_t ui16Max)
+{
+    return byteRingRead(&g_rxRing, pcData, ui16Max);
+}
+
+// Number of received bytes lost because the buffer was full
+uint32_t
+uartRxDropped (void)
+{
+    return g_rxDropped;
+}
+
+//**********************************************************************
+// Request a new baud rate. The switch waits until everything already
+// queued has left the line (see uartPoll()), so a reply sent before
+// this call goes out at the old rate. Returns false if the rate is out
+// of range for the UART clock.
+//**********************************************************************
+bool
+uartSetBaud (uint32_t ui32Baud)
+{
+    // 16x oversampling: the divisor must be at least 1
+    if (ui32Baud < BAUD_RATE_MIN || ui32Baud > BAUD_RATE_MAX ||
+        ui32Baud > g_uartClock / 16)
+    {
+        return false;
+    }
+
+    g_pendingBaud = ui32Baud;
+    return true;
+}
+
+// Rate the UART is running at
+uint32_t
+uartGetBaud (void)
+{
+    return g_baud;
+}
+
+// True once a requested rate change has taken effect
+bool
+uartBaudSettled (void)
+{
+    return g_pendingBaud == 0;
+}
+
+//**********************************************************************
+// Main loop service: apply a pending baud change once transmission
+// has finished. Never waits.
+//**********************************************************************
+void
+uartPoll (void)
+{
+    if (g_pendingBaud == 0 || !byteRingEmpty(&g_txRing) || uartDmaBusy() ||
+        UARTBusy(UART_USB_BASE))
+    {
+        return;
+    }
+
+    UARTConfigSetExpClk(UART_USB_BASE, g_uartClock, g_pendingBaud, UART_CONFIG);
+    g_baud = g_pendingBaud;
+    g_pendingBaud = 0;
+}
+
+//**********************************************************************
+// Queue a string for transmission via UART0 without blocking
 //**********************************************************************
 void
 UARTSend (char *pucBuffer)
 {
-    // Loop while there are more characters to send.
-    while(*pucBuffer)
+    uint16_t len = 0;
+
+    while (pucBuffer[len])
     {
-        // Write the next character to the UART Tx FIFO.
-        UARTCharPut(UART_USB_BASE, *pucBuffer);
-        pucBuffer++;
+        len++;
     }
+
+    uartWrite(pucBuffer, len);
 }
 
 // Format and send UART data (main & tail duty cycles, current altitude
@@ -69,19 +308,32 @@ void formatUARTOutput(uint16_t main_duty, uint16_t tail_duty, int16_t altitude,
     int16_t desired_alt, int16_t yaw, int16_t desired_yaw, char* mode_name)
 {
     char statusStr[30];
+    char *p;
 
-    sprintf(statusStr, "******\n\r");
-    UARTSend(statusStr);
+    UARTSend("******\n\r");
 
-    sprintf(statusStr, "Main: %d, Tail: %d\n\r", main_duty, tail_duty);
+    p = fmtStr(statusStr, "Main: ");
+    p = fmtUint(p, main_duty, 0);
+    p = fmtStr(p, ", Tail: ");
+    p = fmtUint(p, tail_duty, 0);
+    fmtStr(p, "\n\r");
     UARTSend(statusStr);
 
-    sprintf(statusStr, "Alt: %d [%d]\n\r", altitude, desired_alt);
+    p = fmtStr(statusStr, "Alt: ");
+    p = fmtInt(p, altitude, 0);
+    p = fmtStr(p, " [");
+    p = fmtInt(p, desired_alt, 0);
+    fmtStr(p, "]\n\r");
     UARTSend(statusStr);
 
-    sprintf(statusStr, "Yaw: %d [%d]\n\r", yaw, desired_yaw);
+    p = fmtStr(statusStr, "Yaw: ");
+    p = fmtInt(p, yaw, 0);
+    p = fmtStr(p, " [");
+    p = fmtInt(p, desired_yaw, 0);
+    fmtStr(p, "]\n\r");
     UARTSend(statusStr);
 
-    sprintf(statusStr, "Mode: %s\n\r", mode_name);
-    UARTSend(statusStr);
+    UARTSend("Mode: ");
+    UARTSend(mode_name);
+    UARTSend("\n\r");
 }
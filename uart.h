@@ -8,10 +8,44 @@
 #ifndef UART_H_
 #define UART_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
 void initUART();
 
+// Main loop service: applies pending baud changes. Never waits.
+void uartPoll(void);
+
+// Request a new baud rate (up to 921600), applied once everything
+// already queued has been sent. Returns false if out of range.
+bool uartSetBaud(uint32_t ui32Baud);
+
+uint32_t uartGetBaud(void);
+
+// True once a requested rate change has taken effect
+bool uartBaudSettled(void);
+
+// Take up to ui16Max received bytes without blocking. Returns the
+// number read.
+uint16_t uartRead(char *pcData, uint16_t ui16Max);
+
+// Number of received bytes lost because the buffer was full
+uint32_t uartRxDropped(void);
+
+// Queue bytes for transmission without blocking. Returns the number
+// accepted; the rest are dropped and counted.
+uint16_t uartWrite(const char *pcData, uint16_t ui16Len);
+
+// Number of bytes dropped because the transmit buffer was full
+uint32_t uartTxDropped(void);
+
+// Queue a string for transmission without blocking
 void UARTSend(char* pucBuffer);
 
+// uDMA frame transmit (uartDmaAcquire(), uartDmaSubmit()) is declared
+// in uartDma.h
+#include "uartDma.h"
+
 void formatUARTOutput(uint16_t main_duty, uint16_t tail_duty, int16_t altitude, int16_t desired_alt, int16_t yaw, int16_t desired_yaw, char* mode_name);
 
 
@@ -0,0 +1,134 @@
+/*
+ * uartDma.c
+ *
+ * Buffer bookkeeping for frame transmit by uDMA. Each buffer is free,
+ * being filled by the main loop, queued, or being sent. The main loop
+ * moves a buffer from free to filling to queued; the UART interrupt
+ * moves it from queued to sending to free. No hardware access here;
+ * see uartDma.h for the hooks.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "uartDma.h"
+
+enum dmaBufStates {DMA_BUF_FREE = 0, DMA_BUF_FILLING, DMA_BUF_QUEUED, DMA_BUF_SENDING};
+
+//**********************************************************************
+// Globals to module
+//**********************************************************************
+static uint8_t g_dmaBuf[UART_DMA_NUM_BUFS][UART_DMA_BUF_SIZE];
+static volatile uint16_t g_dmaLen[UART_DMA_NUM_BUFS];
+static volatile uint8_t g_dmaState[UART_DMA_NUM_BUFS];
+static volatile uint32_t g_dmaOrder[UART_DMA_NUM_BUFS];    // Submit count when queued
+static uint32_t g_dmaSubmitted;             // Frames submitted so far
+static volatile int8_t g_dmaSending = -1;   // Buffer on the wire, or -1
+static volatile uint32_t g_dmaDropped;      // Frames refused, no free buffer
+
+//**********************************************************************
+// Start the oldest queued buffer, if there is one and the line is free.
+// Byte-at-a-time output goes first so text and frames never
+// interleave.
+//**********************************************************************
+void
+uartDmaStart (void)
+{
+    int8_t next = -1;
+    uint8_t i;
+
+    if (g_dmaSending >= 0 || !uartDmaDevLineFree()) {
+        return;
+    }
+
+    for (i = 0; i < UART_DMA_NUM_BUFS; i++) {
+        if (g_dmaState[i] == DMA_BUF_QUEUED &&
+            (next < 0 || (int32_t)(g_dmaOrder[i] - g_dmaOrder[next]) < 0)) {
+            next = i;
+        }
+    }
+
+    if (next < 0) {
+        return;
+    }
+
+    g_dmaState[next] = DMA_BUF_SENDING;
+    g_dmaSending = next;
+    uartDmaDevStart(g_dmaBuf[next], g_dmaLen[next]);
+}
+
+//**********************************************************************
+// Completion: once the transfer has stopped, the buffer it was sending
+// is free for the next frame
+//**********************************************************************
+void
+uartDmaPoll (void)
+{
+    if (g_dmaSending >= 0 && uartDmaDevDone()) {
+        g_dmaState[g_dmaSending] = DMA_BUF_FREE;
+        g_dmaSending = -1;
+    }
+}
+
+// True while a transfer owns the UART FIFO
+bool
+uartDmaBusy (void)
+{
+    return g_dmaSending >= 0;
+}
+
+//**********************************************************************
+// Claim a free buffer to build a frame in. Returns NULL, and counts a
+// dropped frame, if both are busy. The interrupt never touches a free
+// buffer, so claiming one needs no lock.
+//**********************************************************************
+uint8_t *
+uartDmaAcquire (void)
+{
+    uint8_t i;
+
+    for (i = 0; i < UART_DMA_NUM_BUFS; i++) {
+        if (g_dmaState[i] == DMA_BUF_FREE) {
+            g_dmaState[i] = DMA_BUF_FILLING;
+            return g_dmaBuf[i];
+        }
+    }
+
+    g_dmaDropped++;
+    return 0;
+}
+
+//**********************************************************************
+// Hand a buffer from uartDmaAcquire() over to send len bytes. The CPU
+// cost is the same whatever the frame size.
+//**********************************************************************
+void
+uartDmaSubmit (uint8_t *pui8Buf, uint16_t ui16Len)
+{
+    uint32_t key;
+    uint8_t i;
+
+    for (i = 0; i < UART_DMA_NUM_BUFS; i++) {
+        if (pui8Buf == g_dmaBuf[i] && g_dmaState[i] == DMA_BUF_FILLING) {
+            break;
+        }
+    }
+    if (i == UART_DMA_NUM_BUFS) {
+        return;
+    }
+
+    g_dmaLen[i] = (ui16Len > UART_DMA_BUF_SIZE) ? UART_DMA_BUF_SIZE : ui16Len;
+
+    key = uartDmaDevLock();
+    g_dmaOrder[i] = g_dmaSubmitted++;
+    g_dmaState[i] = DMA_BUF_QUEUED;
+    uartDmaStart();
+    uartDmaDevUnlock(key);
+}
+
+// Number of frames dropped because no buffer was free
+uint32_t
+uartDmaDropped (void)
+{
+    return g_dmaDropped;
+}
@@ -0,0 +1,82 @@
+/*
+ * uartDma.h
+ *
+ * Frame transmit by uDMA from a pair of buffers. Claim a buffer, build
+ * the frame in it, then submit it. Frames go out in the order they
+ * were submitted, and each buffer is recycled when its transfer
+ * completes.
+ *
+ * uartDma.c does only the buffer bookkeeping. It reaches the hardware
+ * through the uartDmaDev*() hooks at the end of this file. uart.c
+ * implements them on the uDMA controller; defining UART_DMA_SIM builds
+ * uartDmaSim.c instead, a fake DMA engine for running on a PC.
+ */
+
+#ifndef UARTDMA_H_
+#define UARTDMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UART_DMA_BUF_SIZE       64
+#define UART_DMA_NUM_BUFS       2
+
+// Claim a free buffer (UART_DMA_BUF_SIZE bytes) to build a frame in.
+// Returns NULL, and counts a dropped frame, if both are busy.
+uint8_t *uartDmaAcquire(void);
+
+// Queue a claimed buffer to send len bytes
+void uartDmaSubmit(uint8_t *pui8Buf, uint16_t ui16Len);
+
+// Number of frames dropped because no buffer was free
+uint32_t uartDmaDropped(void);
+
+// Driver side. Call from the UART interrupt, or with it masked.
+
+// True while a transfer owns the UART FIFO
+bool uartDmaBusy(void);
+
+// Recycle the buffer being sent if its transfer has finished
+void uartDmaPoll(void);
+
+// Start the oldest queued buffer, if any, once the line is free
+void uartDmaStart(void);
+
+// Hooks, supplied by uart.c or uartDmaSim.c
+
+// Start sending len bytes from buf to the UART data register
+void uartDmaDevStart(const uint8_t *pui8Buf, uint16_t ui16Len);
+
+// True once the transfer last started has finished
+bool uartDmaDevDone(void);
+
+// True if no byte-at-a-time output is waiting, so a frame can't split it
+bool uartDmaDevLineFree(void);
+
+// Mask and unmask the UART interrupt around bookkeeping changes
+uint32_t uartDmaDevLock(void);
+
+void uartDmaDevUnlock(uint32_t ui32Key);
+
+#ifdef UART_DMA_SIM
+// Fake engine controls. A started transfer runs until
+// uartDmaSimComplete(); its bytes are then appended to the output log.
+void uartDmaSimReset(void);
+
+bool uartDmaSimRunning(void);
+
+void uartDmaSimComplete(void);
+
+void uartDmaSimSetLineFree(bool bFree);
+
+// Take up to max bytes from the output log. Returns the number taken.
+uint16_t uartDmaSimOutput(uint8_t *pui8Out, uint16_t ui16Max);
+
+// Transfers started while one was already running, and the current
+// lock nesting depth; both should always be 0 between calls
+uint32_t uartDmaSimOverlaps(void);
+
+uint32_t uartDmaSimLockDepth(void);
+#endif
+
+#endif /* UARTDMA_H_ */
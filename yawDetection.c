@@ -16,6 +16,12 @@
 #include "driverlib/sysctl.h"
 
 #include "yawDetection.h"
+#include "fastGPIO.h"
+#include "intPriority.h"
+#include "isrTiming.h"
+
+// *** constants
+#define YAW_BENCH_PASSES        64      // Passes averaged by benchYawGPIO()
 
 // *** globals
 static int32_t yaw_degrees;             // Yaw calculation in degrees
@@ -23,7 +29,20 @@ volatile static int32_t yaw;            // Raw, unconverted yaw value
 static int32_t state_yaw = 0;           // Tracks current state of the yaw calculation
 static int32_t prev_state_yaw = 0;      // Tracks previous state of yaw calculation
 volatile static int16_t yawRef = 1;     // Stores whether the ref signal has been reached
-volatile static int16_t g_trigger = 0;
+volatile static int32_t yaw_offset = 0;     // Raw count latched at the first ref edge
+volatile static int32_t yaw_ref_last = 0;   // Raw count latched at the latest ref edge
+volatile static int32_t yaw_ref_drift = 0;  // Count error seen at the latest ref edge
+volatile static int32_t yaw_ref_drift_max = 0;  // Largest count error seen so far
+
+//*************************************************************************
+// Convert the raw count into degrees relative to the reference
+//*************************************************************************
+static void
+updateYawDegrees (void)
+{
+    yaw_degrees = wrapYaw(((yaw - yaw_offset) * YAW_DEGREES_PER_REV)
+                          / YAW_COUNTS_PER_REV);
+}
 
 //*************************************************************************
 // ISR and Yaw Quadrature encoding
@@ -31,15 +50,18 @@ volatile static int16_t g_trigger = 0;
 void
 handleYaw (void)
 {
-    int32_t PinA;
-    int32_t PinB;
+    uint32_t start = isrTimingStart();
+    uint32_t Pins;
+    uint32_t PinA;
+    uint32_t PinB;
 
     // Clear the interrupt (documentation recommends doing this early)
-    GPIOIntClear (GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+    fastGPIOIntClear (GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
 
-    // Reads pin values
-    PinA = GPIOPinRead (GPIO_PORTB_BASE, GPIO_PIN_0);
-    PinB = GPIOPinRead (GPIO_PORTB_BASE, GPIO_PIN_1);
+    // Reads both pin values in one access so they are sampled together
+    Pins = fastGPIORead (GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+    PinA = Pins & GPIO_PIN_0;
+    PinB = Pins & GPIO_PIN_1;
 
     // Yaw States
     if (!PinA) {
@@ -86,24 +108,54 @@ handleYaw (void)
     }
     prev_state_yaw = state_yaw;
 
-    // Sets yaw_degrees
-    yaw_degrees = (yaw * 360) / 448;
+    // Sets yaw_degrees, wrapped into [-180, 180)
+    updateYawDegrees();
+
+    isrTimingEnd(ISR_YAW, start);
 }
 
 // Interrupt handler for yaw interrupt
 void yawRefHandler (void)
 {
-    // detect interrupt
-    GPIOIntClear(GPIO_PORTC_BASE, GPIO_PIN_4);
+    uint32_t start = isrTimingStart();
+    int32_t counts;
 
-    yawRef = 0;
-    yaw = 1;
+    // detect interrupt
+    fastGPIOIntClear(GPIO_PORTC_BASE, GPIO_PIN_4);
 
-    if (!yawRef && g_trigger == 0)
+    if (yawRef)
     {
-        yaw = 0;
-        g_trigger = 1;
+        // First edge: latch the count at the index so zero is exact,
+        // independent of how long the main loop takes to notice
+        yaw_offset = yaw;
+        yaw_ref_last = yaw;
+        yawRef = 0;
+        updateYawDegrees();
+        isrTimingEnd(ISR_YAW_REF, start);
+        return;
     }
+
+    // Later edges: the count since the previous edge should be a whole
+    // number of revolutions. Anything left over is drift.
+    counts = (yaw - yaw_ref_last) % YAW_COUNTS_PER_REV;
+    if (counts >= YAW_COUNTS_PER_REV / 2) {
+        counts -= YAW_COUNTS_PER_REV;
+    }
+    else if (counts < -YAW_COUNTS_PER_REV / 2) {
+        counts += YAW_COUNTS_PER_REV;
+    }
+
+    yaw_ref_drift = counts;
+    if (counts < 0) {
+        counts = -counts;
+    }
+    if (counts > yaw_ref_drift_max) {
+        yaw_ref_drift_max = counts;
+    }
+
+    yaw_ref_last = yaw;
+
+    isrTimingEnd(ISR_YAW_REF, start);
 }
 
 //*************************************************************************
@@ -133,6 +185,7 @@ initYaw(void)
     GPIOIntEnable(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
 
     // Enable interrupts on port B
+    IntPrioritySet(INT_GPIOB, INT_PRIORITY_YAW);
     IntEnable(INT_GPIOB);
 }
 
@@ -153,17 +206,68 @@ void initRef (void)
     GPIOIntRegister(GPIO_PORTC_BASE, yawRefHandler);
 
     GPIOIntEnable(GPIO_PORTC_BASE, GPIO_PIN_4);
+    IntPrioritySet(INT_GPIOC, INT_PRIORITY_YAW_REF);
     IntEnable(INT_GPIOC);
 }
 
+//*************************************************************************
+// Time the encoder ISR's pin accesses, in CPU cycles per pass: one pin
+// interrupt clear and one two-pin read, through fastGPIO.h or through
+// the driverlib calls the ISRs used before. Loop overhead is included
+// in both. The clear names no pins so a pending edge is never lost.
+//*************************************************************************
+uint32_t benchYawGPIO(bool fast)
+{
+    volatile uint32_t pins;
+    uint32_t start;
+    uint32_t cycles;
+    uint8_t i;
+
+    start = isrTimingStart();
+    if (fast) {
+        for (i = 0; i < YAW_BENCH_PASSES; i++) {
+            fastGPIOIntClear(GPIO_PORTB_BASE, 0);
+            pins = fastGPIORead(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+        }
+    }
+    else {
+        for (i = 0; i < YAW_BENCH_PASSES; i++) {
+            GPIOIntClear(GPIO_PORTB_BASE, 0);
+            pins = GPIOPinRead(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+        }
+    }
+    cycles = isrTimingStart() - start;
+    (void)pins;
+
+    return cycles / YAW_BENCH_PASSES;
+}
+
 // Return calculated yaw value
 int getYaw(void)
 {
     return yaw_degrees;
 }
 
+// Return the raw, unwrapped encoder count
+int32_t getYawCounts(void)
+{
+    return yaw;
+}
+
 // Return boolean value storing state of yaw ref
 int checkYawRef(void)
 {
     return (yawRef);
 }
+
+// Return the count error measured at the most recent ref edge
+int32_t getYawRefDrift(void)
+{
+    return yaw_ref_drift;
+}
+
+// Return the largest count error measured at any ref edge
+int32_t getYawRefDriftMax(void)
+{
+    return yaw_ref_drift_max;
+}
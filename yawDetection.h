@@ -8,6 +8,12 @@
 #ifndef YAWDETECTION_H_
 #define YAWDETECTION_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define YAW_COUNTS_PER_REV      448     // Quadrature counts per full revolution
+#define YAW_DEGREES_PER_REV     360
+
 void changeYaw(int32_t changeValue);
 
 //*************************************************************************
@@ -20,10 +26,32 @@ void initYaw(void);
 //*********************************************************
 void initRef(void);
 
-// Return calculated yaw value
+// Angle wrapping, in yawWrap.c. No hardware access, so tests/ builds
+// it on a PC.
+
+// Wrap an angle in degrees into the range [-180, 180)
+int32_t wrapYaw(int32_t degrees);
+
+// Shortest signed angle from actual to desired, in [-180, 180)
+int32_t yawError(int32_t desired, int32_t actual);
+
+// Return calculated yaw value, wrapped into [-180, 180)
 int getYaw(void);
 
+// Return the raw, unwrapped encoder count
+int32_t getYawCounts(void);
+
 // Return boolean value storing state of yaw ref
 int checkYawRef(void);
 
+// Return the count error measured at the most recent ref edge
+int32_t getYawRefDrift(void);
+
+// Return the largest count error measured at any ref edge
+int32_t getYawRefDriftMax(void);
+
+// CPU cycles for the encoder ISR's pin clear and read, through
+// fastGPIO.h (fast) or driverlib
+uint32_t benchYawGPIO(bool fast);
+
 #endif /* YAWDETECTION_H_ */
@@ -0,0 +1,37 @@
+/*
+ * yawWrap.c
+ *
+ * Yaw angle wrapping. Plain integer code with no hardware access, kept
+ * out of yawDetection.c so the host tests can build it.
+ */
+
+#include <stdint.h>
+
+#include "yawDetection.h"
+
+//*************************************************************************
+// Wrap an angle in degrees into the range [-180, 180)
+//*************************************************************************
+int32_t wrapYaw(int32_t degrees)
+{
+    degrees %= YAW_DEGREES_PER_REV;
+
+    // C remainder keeps the sign of the dividend, so fold it into the
+    // half-open range
+    if (degrees >= YAW_DEGREES_PER_REV / 2) {
+        degrees -= YAW_DEGREES_PER_REV;
+    }
+    else if (degrees < -YAW_DEGREES_PER_REV / 2) {
+        degrees += YAW_DEGREES_PER_REV;
+    }
+
+    return degrees;
+}
+
+//*************************************************************************
+// Shortest signed angle from actual to desired, in [-180, 180)
+//*************************************************************************
+int32_t yawError(int32_t desired, int32_t actual)
+{
+    return wrapYaw(desired - actual);
+}